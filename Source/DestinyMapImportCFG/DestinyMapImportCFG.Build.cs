@@ -48,6 +48,12 @@ public class DestinyMapImportCFG : ModuleRules
 				"EditorScriptingUtilities",
 				"AssetTools",
 				"DesktopPlatform",
+				"ImageCore",
+				"ImageWrapper",
+				"InterchangeCore",
+				"InterchangeEngine",
+				"InterchangePipelines",
+				"DataLayerEditor",
 				//"UnrealEdFbx",
 				// ... add private dependencies that you statically link with here ...	
 			}
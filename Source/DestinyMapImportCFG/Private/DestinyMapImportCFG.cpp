@@ -3,6 +3,14 @@
 #include "DestinyMapImportCFG.h"
 #include "DestinyMapImportCFGStyle.h"
 #include "DestinyMapImportCFGCommands.h"
+#include "DestinyMapImportCFGInstances.h"
+#include "DestinyMapImportCFGReader.h"
+#include "DestinyMapImportCFGCache.h"
+#include "DestinyMapImportCFGTextures.h"
+#include "DestinyMapImportCFGAssetsIndex.h"
+#include "DestinyMapImportCFGInterchange.h"
+#include "DestinyMapImportCFGJobGraph.h"
+#include "DestinyMapImportCFGManifest.h"
 #include "LevelEditor.h"
 #include "Widgets/Docking/SDockTab.h"
 #include "Widgets/Layout/SBox.h"
@@ -13,6 +21,7 @@
 #include "IDesktopPlatform.h"
 #include "Misc/Paths.h"
 #include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
 #include "Json.h"
 #include "JsonUtilities.h"
 #include "AssetRegistry/AssetRegistryModule.h"
@@ -53,11 +62,142 @@
 #include "ToolMenus.h"
 #include "Engine/SkeletalMesh.h"
 #include "Materials/MaterialExpressionTextureSample.h"
+#include "Materials/MaterialExpressionTextureSampleParameter2D.h"
+#include "Async/ParallelFor.h"
+#include "MaterialShared.h"
+#include "Misc/SecureHash.h"
+#include "LevelEditorViewport.h"
+#include "Algo/StableSort.h"
+#include "DataLayer/DataLayerEditorSubsystem.h"
+#include "WorldPartition/DataLayer/DataLayerAsset.h"
+#include "WorldPartition/DataLayer/DataLayerInstance.h"
+#include "WorldPartition/DataLayer/WorldDataLayers.h"
 
 static const FName DestinyMapImportCFGTabName("DestinyMapImportCFG");
 
 #define LOCTEXT_NAMESPACE "FDestinyMapImportCFGModule"
 
+// Adds a registered HISM to Container, the first one becomes the root so the batch keeps its instances when saved
+static UHierarchicalInstancedStaticMeshComponent* AddInstancedMeshComponent(AActor* Container, UStaticMesh* MeshAsset)
+{
+	UHierarchicalInstancedStaticMeshComponent* HISM = NewObject<UHierarchicalInstancedStaticMeshComponent>(Container, NAME_None, RF_Transactional);
+	HISM->SetStaticMesh(MeshAsset);
+	if (USceneComponent* RootComponent = Container->GetRootComponent())
+	{
+		HISM->SetupAttachment(RootComponent);
+	}
+	else
+	{
+		Container->SetRootComponent(HISM);
+	}
+	Container->AddInstanceComponent(HISM);
+	HISM->RegisterComponent();
+	return HISM;
+}
+
+// Spawns a container at Location holding world space Transforms as one HISM, the cluster tree is built once for the whole batch
+static AActor* SpawnInstancedBatch(UWorld* World, UStaticMesh* MeshAsset, const FVector& Location, const TArray<FTransform>& Transforms, const FActorSpawnParameters& SpawnParameters)
+{
+	AActor* Container = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParameters);
+	UHierarchicalInstancedStaticMeshComponent* HISM = AddInstancedMeshComponent(Container, MeshAsset);
+	Container->SetActorLocation(Location);
+	if (Transforms.Num() > 0)
+	{
+		HISM->bAutoRebuildTreeOnInstanceChanges = false;
+		HISM->AddInstances(Transforms, false, true);
+		HISM->bAutoRebuildTreeOnInstanceChanges = true;
+		HISM->BuildTreeIfOutdated(false, true);
+	}
+	return Container;
+}
+
+// Spreads the low 10 bits of Value two bits apart, so three of them interleave into a 30 bit Morton code
+static uint32 SpreadMortonBits(uint32 Value)
+{
+	Value &= 0x3FF;
+	Value = (Value | (Value << 16)) & 0x030000FF;
+	Value = (Value | (Value << 8)) & 0x0300F00F;
+	Value = (Value | (Value << 4)) & 0x030C30C3;
+	Value = (Value | (Value << 2)) & 0x09249249;
+	return Value;
+}
+
+// Orders transforms along a Z-order curve over their own bounds, so instances that are close in the world are close in the HISM
+static void SortByMortonOrder(TArray<FTransform>& Transforms)
+{
+	if (Transforms.Num() < 2) return;
+
+	FBox Bounds(ForceInit);
+	for (const FTransform& Transform : Transforms)
+	{
+		Bounds += Transform.GetLocation();
+	}
+	const FVector Scale = FVector(1023.0) / Bounds.GetSize().ComponentMax(FVector(1.0));
+
+	TArray<TPair<uint32, FTransform>> Keyed;
+	Keyed.Reserve(Transforms.Num());
+	for (const FTransform& Transform : Transforms)
+	{
+		const FVector Local = (Transform.GetLocation() - Bounds.Min) * Scale;
+		const uint32 Key = SpreadMortonBits((uint32)Local.X) | (SpreadMortonBits((uint32)Local.Y) << 1) | (SpreadMortonBits((uint32)Local.Z) << 2);
+		Keyed.Emplace(Key, Transform);
+	}
+	Algo::StableSortBy(Keyed, [](const TPair<uint32, FTransform>& Entry) { return Entry.Key; });
+
+	for (int32 Index = 0; Index < Keyed.Num(); ++Index)
+	{
+		Transforms[Index] = Keyed[Index].Value;
+	}
+}
+
+// Groups transforms by the CellSize square of the XY plane (cube if bSplitHeight) their location falls in, each group Morton sorted
+static TMap<FIntVector, TArray<FTransform>> SplitIntoGridCells(const TArray<FTransform>& Transforms, float CellSize, bool bSplitHeight)
+{
+	TMap<FIntVector, TArray<FTransform>> Cells;
+	for (const FTransform& Transform : Transforms)
+	{
+		const FVector Location = Transform.GetLocation();
+		const FIntVector Cell(
+			FMath::FloorToInt32(Location.X / CellSize),
+			FMath::FloorToInt32(Location.Y / CellSize),
+			bSplitHeight ? FMath::FloorToInt32(Location.Z / CellSize) : 0);
+		Cells.FindOrAdd(Cell).Add(Transform);
+	}
+	for (TPair<FIntVector, TArray<FTransform>>& Cell : Cells)
+	{
+		SortByMortonOrder(Cell.Value);
+	}
+	return Cells;
+}
+
+// Data layer assets are shared by every map, one per CFG Type, the level only gets an instance of each
+static UDataLayerInstance* GetOrCreateTypeDataLayer(UWorld* World, const FString& DataLayerName)
+{
+	AWorldDataLayers* WorldDataLayers = World->GetWorldDataLayers();
+	UDataLayerEditorSubsystem* DataLayerSubsystem = UDataLayerEditorSubsystem::Get();
+	if (!WorldDataLayers || !DataLayerSubsystem) return nullptr;
+
+	const FString AssetName = TEXT("DL_") + DataLayerName;
+	const FString PackagePath = TEXT("/Game/DestinyMapImportCFG/DataLayers/") + AssetName;
+	UDataLayerAsset* DataLayerAsset = Cast<UDataLayerAsset>(UEditorAssetLibrary::LoadAsset(PackagePath + TEXT(".") + AssetName));
+	if (!DataLayerAsset)
+	{
+		UPackage* Package = CreatePackage(*PackagePath);
+		DataLayerAsset = NewObject<UDataLayerAsset>(Package, *AssetName, RF_Public | RF_Standalone | RF_Transactional);
+		DataLayerAsset->MarkPackageDirty();
+		FAssetRegistryModule::AssetCreated(DataLayerAsset);
+	}
+
+	if (const UDataLayerInstance* ExistingInstance = WorldDataLayers->GetDataLayerInstance(DataLayerAsset))
+	{
+		return const_cast<UDataLayerInstance*>(ExistingInstance);
+	}
+	FDataLayerCreationParameters CreationParameters;
+	CreationParameters.DataLayerAsset = DataLayerAsset;
+	CreationParameters.WorldDataLayers = WorldDataLayers;
+	return DataLayerSubsystem->CreateDataLayerInstance(CreationParameters);
+}
+
 
 
 
@@ -102,6 +242,8 @@ void FDestinyMapImportCFGModule::ShutdownModule()
 	FDestinyMapImportCFGCommands::Unregister();
 
 	FGlobalTabmanager::Get()->UnregisterNomadTabSpawner(DestinyMapImportCFGTabName);
+
+	RunningSessions.Reset();
 }
 
 
@@ -149,8 +291,8 @@ TSharedRef<SDockTab> FDestinyMapImportCFGModule::OnSpawnPluginTab(const FSpawnTa
 				.Padding(5)
 				[
 					SNew(SCheckBox)
-						.IsChecked_Lambda([this]() { return bImportTextures ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
-						.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState) { bImportTextures = (NewState == ECheckBoxState::Checked); })
+						.IsChecked_Lambda([this]() { return Settings.bImportTextures ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
+						.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState) { Settings.bImportTextures = (NewState == ECheckBoxState::Checked); })
 						.Content()
 						[
 							SNew(STextBlock).Text(FText::FromString("Import Textures"))
@@ -169,10 +311,10 @@ TSharedRef<SDockTab> FDestinyMapImportCFGModule::OnSpawnPluginTab(const FSpawnTa
 				.Padding(5)
 				[
 					SNew(SCFGTextureFormatCombo)
-						.IsEnabled_Lambda([this]() { return bImportTextures; })
+						.IsEnabled_Lambda([this]() { return Settings.bImportTextures; })
 						.OnFormatChanged(FOnFormatChanged::CreateLambda([this](ETextureFormat Format)
 					{
-						this->SelectedFormat = Format;
+						this->Settings.SelectedFormat = Format;
 					}))
 				]
 
@@ -183,8 +325,8 @@ TSharedRef<SDockTab> FDestinyMapImportCFGModule::OnSpawnPluginTab(const FSpawnTa
 				.AutoHeight()
 				[
 					SNew(SCheckBox)
-						.IsChecked_Lambda([this]() { return bImportMaterials ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
-						.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState) { bImportMaterials = (NewState == ECheckBoxState::Checked); })
+						.IsChecked_Lambda([this]() { return Settings.bImportMaterials ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
+						.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState) { Settings.bImportMaterials = (NewState == ECheckBoxState::Checked); })
 						.Content()
 						[
 							SNew(STextBlock)
@@ -211,9 +353,9 @@ TSharedRef<SDockTab> FDestinyMapImportCFGModule::OnSpawnPluginTab(const FSpawnTa
 						.AutoHeight()
 						[
 							SNew(SCheckBox)
-								.IsEnabled_Lambda([this]() { return bImportMaterials && bImportTextures; })
-								.IsChecked_Lambda([this]() { return bMaterialGen ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
-								.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState) { bMaterialGen = (NewState == ECheckBoxState::Checked); })
+								.IsEnabled_Lambda([this]() { return Settings.bImportMaterials && Settings.bImportTextures; })
+								.IsChecked_Lambda([this]() { return Settings.bMaterialGen ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
+								.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState) { Settings.bMaterialGen = (NewState == ECheckBoxState::Checked); })
 								.Content()
 								[
 									SNew(STextBlock)
@@ -227,9 +369,57 @@ TSharedRef<SDockTab> FDestinyMapImportCFGModule::OnSpawnPluginTab(const FSpawnTa
 						.AutoHeight()
 						[
 							SNew(SCheckBox)
-								.IsEnabled_Lambda([this]() { return bMaterialGen && bImportMaterials && bImportTextures; })
-								.IsChecked_Lambda([this]() { return bDiffuseApply ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
-								.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState) { bDiffuseApply = (NewState == ECheckBoxState::Checked); })
+								.IsEnabled_Lambda([this]() { return Settings.bImportMaterials; })
+								.IsChecked_Lambda([this]() { return Settings.bUseMaterialInstances ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
+								.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState) { Settings.bUseMaterialInstances = (NewState == ECheckBoxState::Checked); })
+								.Content()
+								[
+									SNew(STextBlock)
+										.Text(FText::FromString("Use Material Instances"))
+										.ToolTipText(FText::FromString("Creates Material Instances of shared master materials instead of one Material per Destiny material"))
+								]
+						]
+						+ SVerticalBox::Slot()
+						.HAlign(HAlign_Left)
+						.VAlign(VAlign_Center)
+						.AutoHeight()
+						[
+							SNew(SCheckBox)
+								.IsEnabled_Lambda([this]() { return Settings.bImportMaterials; })
+								.IsChecked_Lambda([this]() { return Settings.bDedupeMaterials ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
+								.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState) { Settings.bDedupeMaterials = (NewState == ECheckBoxState::Checked); })
+								.Content()
+								[
+									SNew(STextBlock)
+										.Text(FText::FromString("Merge Identical Materials"))
+										.ToolTipText(FText::FromString("Destiny materials with the same textures share one material asset, mesh slots are pointed at it"))
+								]
+						]
+						+ SVerticalBox::Slot()
+						.HAlign(HAlign_Left)
+						.VAlign(VAlign_Center)
+						.AutoHeight()
+						[
+							SNew(SCheckBox)
+								.IsEnabled_Lambda([this]() { return Settings.bImportMaterials || Settings.bImportTextures; })
+								.IsChecked_Lambda([this]() { return Settings.bUseSharedLibrary ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
+								.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState) { Settings.bUseSharedLibrary = (NewState == ECheckBoxState::Checked); })
+								.Content()
+								[
+									SNew(STextBlock)
+										.Text(FText::FromString("Use Shared Asset Library"))
+										.ToolTipText(FText::FromString("Imports textures and materials once to /Game/DestinyShared and reuses them in every map"))
+								]
+						]
+						+ SVerticalBox::Slot()
+						.HAlign(HAlign_Left)
+						.VAlign(VAlign_Center)
+						.AutoHeight()
+						[
+							SNew(SCheckBox)
+								.IsEnabled_Lambda([this]() { return Settings.bMaterialGen && Settings.bImportMaterials && Settings.bImportTextures; })
+								.IsChecked_Lambda([this]() { return Settings.bDiffuseApply ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
+								.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState) { Settings.bDiffuseApply = (NewState == ECheckBoxState::Checked); })
 								.Content()
 								[
 									SNew(STextBlock)
@@ -267,8 +457,8 @@ TSharedRef<SDockTab> FDestinyMapImportCFGModule::OnSpawnPluginTab(const FSpawnTa
 				.Padding(5)
 				[
 					SNew(SCheckBox)
-						.IsChecked_Lambda([this]() { return bUseCurrentMap ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
-						.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState) { bUseCurrentMap = (NewState == ECheckBoxState::Checked); })
+						.IsChecked_Lambda([this]() { return Settings.bUseCurrentMap ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
+						.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState) { Settings.bUseCurrentMap = (NewState == ECheckBoxState::Checked); })
 						.Content()
 						[
 							SNew(STextBlock).Text(FText::FromString("Import To Current Map"))
@@ -282,8 +472,8 @@ TSharedRef<SDockTab> FDestinyMapImportCFGModule::OnSpawnPluginTab(const FSpawnTa
 					SNew(SNumericEntryBox<float>)
 						.MinValue(0.0f)
 						.MaxValue(1000.0f)
-						.Value_Lambda([this]() -> TOptional<float> { return fMapScale; })
-						.OnValueChanged_Lambda([this](float NewValue) { fMapScale = NewValue; })
+						.Value_Lambda([this]() -> TOptional<float> { return Settings.fMapScale; })
+						.OnValueChanged_Lambda([this](float NewValue) { Settings.fMapScale = NewValue; })
 						.LabelVAlign(VAlign_Center)
 						.Label()
 						[
@@ -296,8 +486,8 @@ TSharedRef<SDockTab> FDestinyMapImportCFGModule::OnSpawnPluginTab(const FSpawnTa
 				.Padding(5)
 				[
 					SNew(SCheckBox)
-						.IsChecked_Lambda([this]() { return bImportAtmosphere ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
-						.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState) { bImportAtmosphere = (NewState == ECheckBoxState::Checked); })
+						.IsChecked_Lambda([this]() { return Settings.bImportAtmosphere ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
+						.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState) { Settings.bImportAtmosphere = (NewState == ECheckBoxState::Checked); })
 						.Content()
 						[
 							SNew(STextBlock).Text(FText::FromString("Import Atmosphere"))
@@ -309,8 +499,8 @@ TSharedRef<SDockTab> FDestinyMapImportCFGModule::OnSpawnPluginTab(const FSpawnTa
 				.Padding(5)
 				[
 					SNew(SCheckBox)
-						.IsChecked_Lambda([this]() { return bImportCubeMap ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
-						.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState) { bImportCubeMap = (NewState == ECheckBoxState::Checked); })
+						.IsChecked_Lambda([this]() { return Settings.bImportCubeMap ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
+						.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState) { Settings.bImportCubeMap = (NewState == ECheckBoxState::Checked); })
 						.Content()
 						[
 							SNew(STextBlock).Text(FText::FromString("Import CubeMap"))
@@ -322,13 +512,146 @@ TSharedRef<SDockTab> FDestinyMapImportCFGModule::OnSpawnPluginTab(const FSpawnTa
 				.Padding(5)
 				[
 					SNew(SCheckBox)
-						.IsChecked_Lambda([this]() { return bImportLights ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
-						.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState) { bImportLights = (NewState == ECheckBoxState::Checked); })
+						.IsChecked_Lambda([this]() { return Settings.bInstanceMeshes ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
+						.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState) { Settings.bInstanceMeshes = (NewState == ECheckBoxState::Checked); })
+						.Content()
+						[
+							SNew(STextBlock)
+								.Text(FText::FromString("Instance Repeated Meshes"))
+								.ToolTipText(FText::FromString("Places meshes used at least 'Instancing Threshold' times as one HISM instead of one actor per placement"))
+						]
+				]
+				+ SVerticalBox::Slot()
+				.AutoHeight()
+				.Padding(5)
+				[
+					SNew(SCheckBox)
+						.IsChecked_Lambda([this]() { return Settings.bBulkPlacement ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
+						.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState) { Settings.bBulkPlacement = (NewState == ECheckBoxState::Checked); })
+						.Content()
+						[
+							SNew(STextBlock)
+								.Text(FText::FromString("Bulk Placement"))
+								.ToolTipText(FText::FromString("Pauses realtime viewports while the map builds and labels actors as they spawn without marking the level dirty per actor"))
+						]
+				]
+				+ SVerticalBox::Slot()
+				.AutoHeight()
+				.Padding(5)
+				[
+					SNew(SCheckBox)
+						.IsChecked_Lambda([this]() { return Settings.bWorldPartitionOutput ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
+						.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState) { Settings.bWorldPartitionOutput = (NewState == ECheckBoxState::Checked); })
+						.Content()
+						[
+							SNew(STextBlock)
+								.Text(FText::FromString("World Partition Output"))
+								.ToolTipText(FText::FromString("In a World Partition level, splits instanced batches into grid cells so they stream, and puts each CFG type in its own data layer"))
+						]
+				]
+				+ SVerticalBox::Slot()
+				.AutoHeight()
+				.Padding(5)
+				[
+					SNew(SNumericEntryBox<int32>)
+						.IsEnabled_Lambda([this]() { return Settings.bInstanceMeshes; })
+						.MinValue(1)
+						.Value_Lambda([this]() -> TOptional<int32> { return Settings.InstancingThreshold; })
+						.OnValueChanged_Lambda([this](int32 NewValue) { Settings.InstancingThreshold = FMath::Max(1, NewValue); })
+						.LabelVAlign(VAlign_Center)
+						.Label()
+						[
+							SNew(STextBlock).Text(FText::FromString("Instancing Threshold"))
+						]
+				]
+				+ SVerticalBox::Slot()
+				.AutoHeight()
+				.Padding(5)
+				[
+					SNew(SNumericEntryBox<float>)
+						.MinValue(0.0f)
+						.Value_Lambda([this]() -> TOptional<float> { return Settings.DecoratorCellSize; })
+						.OnValueChanged_Lambda([this](float NewValue) { Settings.DecoratorCellSize = FMath::Max(0.0f, NewValue); })
+						.LabelVAlign(VAlign_Center)
+						.Label()
+						[
+							SNew(STextBlock)
+								.Text(FText::FromString("Decorator Cell Size"))
+								.ToolTipText(FText::FromString("Decorators get one HISM per grid cell of this size (Unreal units) and mesh, 0 keeps one HISM per mesh for the whole map"))
+						]
+				]
+				+ SVerticalBox::Slot()
+				.AutoHeight()
+				.Padding(5)
+				[
+					SNew(SCheckBox)
+						.IsEnabled_Lambda([this]() { return Settings.DecoratorCellSize > 0.0f; })
+						.IsChecked_Lambda([this]() { return Settings.bDecoratorCells3D ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
+						.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState) { Settings.bDecoratorCells3D = (NewState == ECheckBoxState::Checked); })
+						.Content()
+						[
+							SNew(STextBlock)
+								.Text(FText::FromString("3D Decorator Cells"))
+								.ToolTipText(FText::FromString("Also splits decorator cells by height, for maps with areas stacked above each other"))
+						]
+				]
+				+ SVerticalBox::Slot()
+				.AutoHeight()
+				.Padding(5)
+				[
+					SNew(SCheckBox)
+						.IsChecked_Lambda([this]() { return Settings.bImportLights ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
+						.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState) { Settings.bImportLights = (NewState == ECheckBoxState::Checked); })
 						.Content()
 						[
 							SNew(STextBlock).Text(FText::FromString("Import Lights"))
 						]
 				]
+				+ SVerticalBox::Slot()
+				.AutoHeight()
+				.Padding(5)
+				[
+					SNew(SCheckBox)
+						.IsChecked_Lambda([this]() { return Settings.bCacheParsedCFG ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
+						.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState) { Settings.bCacheParsedCFG = (NewState == ECheckBoxState::Checked); })
+						.Content()
+						[
+							SNew(STextBlock)
+								.Text(FText::FromString("Cache Parsed CFGs"))
+								.ToolTipText(FText::FromString("Writes a binary *.cfgcache next to each CFG and Lights.json so later imports and builds skip the JSON"))
+						]
+				]
+				+ SVerticalBox::Slot()
+				.AutoHeight()
+				.Padding(5)
+				[
+					SNew(SCheckBox)
+						.IsChecked_Lambda([this]() { return Settings.bUseInterchange ? ECheckBoxState::Checked : ECheckBoxState::Unchecked; })
+						.OnCheckStateChanged_Lambda([this](ECheckBoxState NewState) { Settings.bUseInterchange = (NewState == ECheckBoxState::Checked); })
+						.Content()
+						[
+							SNew(STextBlock)
+								.Text(FText::FromString("Import Models With Interchange"))
+								.ToolTipText(FText::FromString("Imports the FBX files asynchronously through Interchange instead of the FBX factory, the editor stays usable while models import"))
+						]
+				]
+				+ SVerticalBox::Slot()
+				.AutoHeight()
+				.Padding(5)
+				[
+					SNew(SNumericEntryBox<int32>)
+						.IsEnabled_Lambda([this]() { return !Settings.bUseInterchange; })
+						.MinValue(1)
+						.Value_Lambda([this]() -> TOptional<int32> { return Settings.ModelImportBatchSize; })
+						.OnValueChanged_Lambda([this](int32 NewValue) { Settings.ModelImportBatchSize = FMath::Max(1, NewValue); })
+						.LabelVAlign(VAlign_Center)
+						.Label()
+						[
+							SNew(STextBlock)
+								.Text(FText::FromString("Model Import Batch Size"))
+								.ToolTipText(FText::FromString("Number of FBX files handed to the importer per call"))
+						]
+				]
 				/*
 				+ SVerticalBox::Slot()
 				.AutoHeight()
@@ -337,8 +660,8 @@ TSharedRef<SDockTab> FDestinyMapImportCFGModule::OnSpawnPluginTab(const FSpawnTa
 					SNew(SNumericEntryBox<float>)
 						.MinValue(0.0f)
 						.MaxValue(100000.0f)
-						.Value_Lambda([this]() -> TOptional<float> { return fLightIntensity; })
-						.OnValueChanged_Lambda([this](float NewValue) { fLightIntensity = NewValue; })
+						.Value_Lambda([this]() -> TOptional<float> { return Settings.fLightIntensity; })
+						.OnValueChanged_Lambda([this](float NewValue) { Settings.fLightIntensity = NewValue; })
 						.LabelVAlign(VAlign_Center)
 						.Label()
 						[
@@ -393,102 +716,145 @@ void FDestinyMapImportCFGModule::BuildMapButtonClicked()
 	TArray<FString> OutFiles;
 	if (!DesktopPlatform->OpenFileDialog(ParentWindowHandle, TEXT("Choose Charm CFG File/s"), FPaths::ProjectContentDir(), TEXT(""), TEXT("CFG files (*.cfg)|*.cfg|All files (*.*)|*.*"), EFileDialogFlags::Multiple, OutFiles)) return;
 	if (OutFiles.Num() == 0) return;
-	FDestinyMapImportCFGModule::FImportToMap(OutFiles);
-	
-	FString ConfigPath = OutFiles[0];
-	if (bImportLights == true)
-	{
-		FDestinyMapImportCFGModule::FImportLightingToMap(ConfigPath);
-	}
+	FDestinyMapImportCFGModule::FBuildMap(OutFiles);
 }
 
-void FDestinyMapImportCFGModule::FImportLightingToMap(FString ConfigPath)
+void FDestinyMapImportCFGModule::FBuildMap(TArray<FString> OutFiles)
 {
-	CFGFolderName = FPaths::GetCleanFilename(FPaths::GetPath(ConfigPath)).Replace(TEXT(" "), TEXT("_"));
-	FString LightsPath = FPaths::Combine(FPaths::GetPath(ConfigPath), TEXT("/Rendering/Lights.json"));
-	FString JsonRaw;
-	if (!FFileHelper::LoadFileToString(JsonRaw, *LightsPath))
+	FCharmImportSession Session(Settings);
+
+	// Bulk placement: viewports stop rendering in realtime and actors are labelled without a per-actor Modify.
+	// Labels and folders are applied before each actor is announced, so the outliner gets one add per actor and no rename or move
+	const FText RealtimeOverrideName = LOCTEXT("BulkPlacementRealtimeOverride", "Destiny Map Build");
+	if (Session.Settings.bBulkPlacement)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Failed to load lights JSON from %s"), *LightsPath);
-		return;
+		for (FLevelEditorViewportClient* ViewportClient : GEditor->GetLevelViewportClients())
+		{
+			ViewportClient->AddRealtimeOverride(false, RealtimeOverrideName);
+		}
 	}
 
-	TSharedPtr<FJsonObject> RootObj;
-	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(JsonRaw);
-	if (!FJsonSerializer::Deserialize(Reader, RootObj) || !RootObj.IsValid())
+	UWorld* World = GEditor->GetEditorWorldContext().World();
+	if (Session.Settings.bWorldPartitionOutput && (!World || !World->IsPartitionedWorld()))
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Failed to parse lights JSON"));
-		return;
+		UE_LOG(LogTemp, Warning, TEXT("World Partition output needs a World Partition level, placing into the open level as usual"));
 	}
 
-	for (const auto& LightPair : RootObj->Values)
+	FCharmImportJobGraph Graph(TEXT("Map build"));
+	const int32 PlaceStage = Graph.AddStage(TEXT("Place"), [this, &Session, &OutFiles]()
 	{
-		FString LightName = LightPair.Key;
-		TSharedPtr<FJsonObject> LightObj = LightPair.Value->AsObject();
-		if (!LightObj.IsValid()) continue;
-
-		const TArray<TSharedPtr<FJsonValue>>* Instances;
-		if (!LightObj->TryGetArrayField("Instances", Instances)) continue;
-
-		FString Type = LightObj->GetStringField("Type");
-
-		FLinearColor Color = FLinearColor::White;
-		if (LightObj->HasTypedField<EJson::Array>("Color"))
+		FDestinyMapImportCFGModule::FImportToMap(Session, OutFiles);
+	});
+	const int32 LightsStage = Graph.AddStage(TEXT("Lights"), [this, &Session, &OutFiles]()
+	{
+		if (Session.Settings.bImportLights == true && OutFiles.Num() > 0)
 		{
-			const TArray<TSharedPtr<FJsonValue>>& ColorArray = LightObj->GetArrayField("Color");
-			if (ColorArray.Num() >= 3)
-			{
-				Color.R = ColorArray[0]->AsNumber();
-				Color.G = ColorArray[1]->AsNumber();
-				Color.B = ColorArray[2]->AsNumber();
-				if (ColorArray.Num() >= 4)
-					Color.A = ColorArray[3]->AsNumber();
-			}
+			FDestinyMapImportCFGModule::FImportLightingToMap(Session, OutFiles[0]);
 		}
+	});
+	Graph.AddStage(TEXT("DataLayers"), [this, &Session, World]()
+	{
+		FDestinyMapImportCFGModule::FAssignDataLayers(Session, World);
+	}, { PlaceStage, LightsStage });
+	Graph.AddStage(TEXT("Levels"), [this, &Session]()
+	{
+		FDestinyMapImportCFGModule::FMarkPlacedLevelsDirty(Session);
+	}, { PlaceStage, LightsStage });
+	Graph.Run();
 
-		float Attenuation = 1000.f;
-		if (LightObj->HasTypedField<EJson::Number>("Attenuation"))
+	if (Session.Settings.bBulkPlacement)
+	{
+		for (FLevelEditorViewportClient* ViewportClient : GEditor->GetLevelViewportClients())
 		{
-			Attenuation = LightObj->GetNumberField("Attenuation") * 1000.f;
+			ViewportClient->RemoveRealtimeOverride(RealtimeOverrideName, false);
 		}
+		GEngine->BroadcastLevelActorListChanged();
+		GEditor->RedrawLevelEditingViewports();
+	}
+}
+
+FActorSpawnParameters FDestinyMapImportCFGModule::FMakePlacementParameters(FCharmImportSession& Session, const FString& Label, const FString& OutlinerFolder, const FString& DataLayer)
+{
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.CustomPreSpawnInitalization = [this, &Session, Label, OutlinerFolder, DataLayer](AActor* Actor)
+	{
+		FDestinyMapImportCFGModule::FRegisterPlacedActor(Session, Actor, Label, OutlinerFolder, DataLayer);
+	};
+	return SpawnParameters;
+}
 
-		FString CookieHash;
-		if (LightObj->HasTypedField<EJson::String>("Cookie"))
+// Runs from FActorSpawnParameters::CustomPreSpawnInitalization, before the level and the outliner are told about the actor
+void FDestinyMapImportCFGModule::FRegisterPlacedActor(FCharmImportSession& Session, AActor* Actor, const FString& Label, const FString& OutlinerFolder, const FString& DataLayer)
+{
+	if (Session.Settings.bWorldPartitionOutput)
+	{
+		Session.PendingDataLayerActors.FindOrAdd(DataLayer).Add(Actor);
+	}
+	Actor->SetActorLabel(Label, !Session.Settings.bBulkPlacement);
+	if (!OutlinerFolder.IsEmpty()) Actor->SetFolderPath(FName(*OutlinerFolder));
+	if (Session.Settings.bBulkPlacement) Session.PlacedLevels.Add(Actor->GetLevel());
+}
+
+void FDestinyMapImportCFGModule::FMarkPlacedLevelsDirty(FCharmImportSession& Session)
+{
+	for (const TWeakObjectPtr<ULevel>& Level : Session.PlacedLevels)
+	{
+		if (Level.IsValid()) Level->MarkPackageDirty();
+	}
+	Session.PlacedLevels.Reset();
+}
+
+void FDestinyMapImportCFGModule::FAssignDataLayers(FCharmImportSession& Session, UWorld* World)
+{
+	TMap<FString, TArray<TWeakObjectPtr<AActor>>> PendingDataLayerActors = MoveTemp(Session.PendingDataLayerActors);
+	Session.PendingDataLayerActors.Reset();
+	if (PendingDataLayerActors.Num() == 0 || !World || !World->IsPartitionedWorld()) return;
+
+	// One AddActorsToDataLayer call per Type instead of one per actor
+	for (const TPair<FString, TArray<TWeakObjectPtr<AActor>>>& Pair : PendingDataLayerActors)
+	{
+		UDataLayerInstance* DataLayer = GetOrCreateTypeDataLayer(World, Pair.Key);
+		if (!DataLayer)
 		{
-			CookieHash = LightObj->GetStringField("Cookie");
+			UE_LOG(LogTemp, Warning, TEXT("Could not create data layer for %s"), *Pair.Key);
+			continue;
 		}
 
-		for (const TSharedPtr<FJsonValue>& InstanceVal : *Instances)
+		TArray<AActor*> Actors;
+		Actors.Reserve(Pair.Value.Num());
+		for (const TWeakObjectPtr<AActor>& Actor : Pair.Value)
 		{
-			TSharedPtr<FJsonObject> InstanceObj = InstanceVal->AsObject();
-			if (!InstanceObj.IsValid()) continue;
-
-			FVector Location(
-				InstanceObj->GetArrayField("Translation")[0]->AsNumber(),
-				InstanceObj->GetArrayField("Translation")[1]->AsNumber(),
-				InstanceObj->GetArrayField("Translation")[2]->AsNumber()
-			);
-			Location *= fMapScale;
-			FQuat Rotation(
-				InstanceObj->GetArrayField("Rotation")[0]->AsNumber(),
-				InstanceObj->GetArrayField("Rotation")[1]->AsNumber(),
-				InstanceObj->GetArrayField("Rotation")[2]->AsNumber(),
-				InstanceObj->GetArrayField("Rotation")[3]->AsNumber()
-			);
-			FVector Scale(
-				InstanceObj->GetArrayField("Scale")[0]->AsNumber(),
-				InstanceObj->GetArrayField("Scale")[1]->AsNumber(),
-				InstanceObj->GetArrayField("Scale")[2]->AsNumber()
-			);
-			Location.Y *= -1.f;
-			Rotation.Y *= -1.f;
-			Rotation.W *= -1.f;
-			FTransform Transform(Rotation, Location, Scale);
+			if (Actor.IsValid()) Actors.Add(Actor.Get());
+		}
+		UDataLayerEditorSubsystem::Get()->AddActorsToDataLayer(Actors, DataLayer);
+		UE_LOG(LogTemp, Log, TEXT("Added %d actors to data layer %s"), Actors.Num(), *Pair.Key);
+	}
+}
 
+void FDestinyMapImportCFGModule::FImportLightingToMap(FCharmImportSession& Session, FString ConfigPath)
+{
+	FString FolderName = FCharmCFGContext::GetFolderName(ConfigPath);
+	FString LightsPath = FPaths::Combine(FPaths::GetPath(ConfigPath), TEXT("/Rendering/Lights.json"));
+	TArray<FCharmLight> Lights;
+	const bool bLightsRead = Session.Settings.bCacheParsedCFG ? FCharmCFGCache::ReadLights(LightsPath, Lights) : FCharmCFGReader::ReadLights(LightsPath, Lights);
+	if (!bLightsRead) return;
+
+	for (FCharmLight& CharmLight : Lights)
+	{
+		const FString& LightName = CharmLight.Name;
+		const FString& Type = CharmLight.Type;
+		const FLinearColor& Color = CharmLight.Color;
+		const FString& CookieHash = CharmLight.Cookie;
+
+		CharmLight.Instances.ConvertCharmToUnreal(Session.Settings.fMapScale);
+		TArray<FTransform> Transforms;
+		CharmLight.Instances.ToTransforms(Transforms);
+
+		for (const FTransform& Transform : Transforms)
+		{
 			if (Type == "Line")
 			{
-				ARectLight* Light = GEditor->GetEditorWorldContext().World()->SpawnActor<ARectLight>(ARectLight::StaticClass(), Transform);
-				Light->SetActorLabel(*LightName);
+				ARectLight* Light = GEditor->GetEditorWorldContext().World()->SpawnActor<ARectLight>(ARectLight::StaticClass(), Transform, FDestinyMapImportCFGModule::FMakePlacementParameters(Session, LightName, FString(), TEXT("Lights")));
 				Light->SetCastShadows(false);
 				Light->GetLightComponent()->SetLightColor(Color);
 				//Light->GetLightComponent()->Intensity(fLightIntensity);
@@ -496,8 +862,7 @@ void FDestinyMapImportCFGModule::FImportLightingToMap(FString ConfigPath)
 			}
 			else if (Type == "Spot")
 			{
-				ASpotLight* Light = GEditor->GetEditorWorldContext().World()->SpawnActor<ASpotLight>(ASpotLight::StaticClass(), Transform);
-				Light->SetActorLabel(*LightName);
+				ASpotLight* Light = GEditor->GetEditorWorldContext().World()->SpawnActor<ASpotLight>(ASpotLight::StaticClass(), Transform, FDestinyMapImportCFGModule::FMakePlacementParameters(Session, LightName, FString(), TEXT("Lights")));
 				Light->SetCastShadows(false);
 				Light->GetLightComponent()->SetLightColor(Color);
 				//Light->GetLightComponent()->Intensity(fLightIntensity);
@@ -505,7 +870,7 @@ void FDestinyMapImportCFGModule::FImportLightingToMap(FString ConfigPath)
 
 				if (!CookieHash.IsEmpty())
 				{
-					FString CookieAssetPath = "/Game/" + CFGFolderName + "/Textures/Lights/" + CookieHash + TEXT(".") + CookieHash;
+					FString CookieAssetPath = "/Game/" + FolderName + "/Textures/Lights/" + CookieHash + TEXT(".") + CookieHash;
 					UTexture* CookieTexture = Cast<UTexture>(StaticLoadObject(UTexture::StaticClass(), nullptr, *CookieAssetPath));
 					if (CookieTexture)
 					{
@@ -516,8 +881,7 @@ void FDestinyMapImportCFGModule::FImportLightingToMap(FString ConfigPath)
 			}
 			else if (Type == "Shadowing")
 			{
-				ASpotLight* Light = GEditor->GetEditorWorldContext().World()->SpawnActor<ASpotLight>(ASpotLight::StaticClass(), Transform);
-				Light->SetActorLabel(*LightName);
+				ASpotLight* Light = GEditor->GetEditorWorldContext().World()->SpawnActor<ASpotLight>(ASpotLight::StaticClass(), Transform, FDestinyMapImportCFGModule::FMakePlacementParameters(Session, LightName, FString(), TEXT("Lights")));
 				Light->SetCastShadows(true);
 				Light->GetLightComponent()->SetLightColor(Color);
 				//Light->GetLightComponent()->Intensity(fLightIntensity);
@@ -537,767 +901,749 @@ void FDestinyMapImportCFGModule::ImportCharmCFGButtonClicked()
 	{
 		ParentWindowHandle = FSlateApplication::Get().GetActiveTopLevelWindow()->GetNativeWindow()->GetOSWindowHandle();
 	}
-	UTextureFactory* TextureFactory = NewObject<UTextureFactory>();
-	TextureFactory->AddToRoot();
-	TextureFactory->SuppressImportOverwriteDialog();
-
-	UFbxFactory* FbxFactory = NewObject<UFbxFactory>();
-	FbxFactory->AddToRoot();
-	FbxFactory->ConfigureProperties(); // initializes ImportUI
 
 	TArray<FString> OutFiles;
 	if (!DesktopPlatform->OpenFileDialog(ParentWindowHandle, TEXT("Choose Charm CFG File/s"), FPaths::ProjectContentDir(), TEXT(""), TEXT("CFG files (*.cfg)|*.cfg|All files (*.*)|*.*"), EFileDialogFlags::Multiple, OutFiles)) return;
 	if (OutFiles.Num() == 0) return;
-	for (auto& file : OutFiles)
-	{
-		FString ConfigPath = file;
-		CFGFolderName = FPaths::GetCleanFilename(FPaths::GetPath(ConfigPath)).Replace(TEXT(" "), TEXT("_"));
-
-		FString TextureImportPath = TEXT("/Game/") + CFGFolderName + TEXT("/Textures");
 
-		if (!UEditorAssetLibrary::DoesDirectoryExist(TextureImportPath)) UEditorAssetLibrary::MakeDirectory(TextureImportPath);
-
-		FString FileContents;
-		if (!FFileHelper::LoadFileToString(FileContents, *ConfigPath)) return;
-
-		TSharedPtr<FJsonObject> RootObject;
-		TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(FileContents);
-		if (!FJsonSerializer::Deserialize(Reader, RootObject) || !RootObject.IsValid()) return;
-		if (RootObject->GetStringField("ExportType") != TEXT("Map")) return;
-
-		FString Type = RootObject->GetStringField("Type");
-		FString AssetsPath = RootObject->GetStringField("AssetsPath");
-		TSharedPtr<FJsonObject> Parts = RootObject->GetObjectField("Parts");
+	FDestinyMapImportCFGModule::FImportModels(FDestinyMapImportCFGModule::FBeginImportSession(), OutFiles);
+}
 
-		FString DestinationPath = TEXT("/Game/") + CFGFolderName + TEXT("/Models/") + Type;
+TSharedRef<FCharmImportSession> FDestinyMapImportCFGModule::FBeginImportSession()
+{
+	// New import session, material JSONs and generated materials are only valid for this run
+	return MakeShared<FCharmImportSession>(Settings);
+}
 
-		if (!UEditorAssetLibrary::DoesDirectoryExist(DestinationPath))
-			UEditorAssetLibrary::MakeDirectory(DestinationPath);
+const FCharmAssetsIndex& FDestinyMapImportCFGModule::FGetAssetsIndex(FCharmImportSession& Session, const FString& AssetsPath)
+{
+	// One directory scan per export folder and session, CFGs of the same export share it
+	if (const TSharedPtr<FCharmAssetsIndex>* CachedIndex = Session.AssetsIndices.Find(AssetsPath))
+	{
+		return **CachedIndex;
+	}
+	TSharedPtr<FCharmAssetsIndex> AssetsIndex = MakeShared<FCharmAssetsIndex>();
+	AssetsIndex->Build(AssetsPath);
+	Session.AssetsIndices.Add(AssetsPath, AssetsIndex);
+	return *AssetsIndex;
+}
 
-		for (auto& Pair : Parts->Values)
+bool FDestinyMapImportCFGModule::FDoesAssetExist(FCharmImportSession& Session, const FString& PackageFolder, const FString& AssetName)
+{
+	// One asset registry query per folder and session, e.g. each Models/<Type> or the shared library's Textures
+	TSet<FName>* FolderAssetNames = Session.ExistingAssetNames.Find(PackageFolder);
+	if (!FolderAssetNames)
+	{
+		FolderAssetNames = &Session.ExistingAssetNames.Add(PackageFolder);
+		TArray<FAssetData> ExistingAssets;
+		IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+		AssetRegistry.GetAssetsByPath(FName(*PackageFolder), ExistingAssets, false, false);
+		for (const FAssetData& ExistingAsset : ExistingAssets)
 		{
-			FString ModelName = Pair.Key;
-			TSharedPtr<FJsonObject> SubMap = Pair.Value->AsObject();
-			if (!SubMap.IsValid())
-			{
-				UE_LOG(LogTemp, Error, TEXT("SubMap is invalid for model: %s"), *ModelName);
-				continue;
-			}
-
-			if (SubMap->Values.Num() == 0)
-			{
-				UE_LOG(LogTemp, Warning, TEXT("SubMap->Values is empty for: %s"), *ModelName);
-				continue;
-			}
+			FolderAssetNames->Add(ExistingAsset.AssetName);
+		}
+	}
+	return FolderAssetNames->Contains(FName(*AssetName));
+}
 
+void FDestinyMapImportCFGModule::FNoteImportedAsset(FCharmImportSession& Session, const FString& AssetPath)
+{
+	// A folder that was already listed would otherwise keep reporting the asset as missing for the rest of the session
+	const FString PackageName = FPackageName::ObjectPathToPackageName(AssetPath);
+	if (TSet<FName>* FolderAssetNames = Session.ExistingAssetNames.Find(FPackageName::GetLongPackagePath(PackageName)))
+	{
+		FolderAssetNames->Add(FName(*FPackageName::GetShortName(PackageName)));
+	}
+}
 
-			TArray<FString> ImportedMaterialRefs;
+FCharmImportManifest& FDestinyMapImportCFGModule::FGetImportManifest(FCharmImportSession& Session, const FString& FolderName)
+{
+	if (const TSharedPtr<FCharmImportManifest>* CachedManifest = Session.Manifests.Find(FolderName))
+	{
+		return **CachedManifest;
+	}
+	TSharedPtr<FCharmImportManifest> Manifest = MakeShared<FCharmImportManifest>(FCharmImportManifest::GetManifestPath(FolderName));
+	Session.Manifests.Add(FolderName, Manifest);
+	return *Manifest;
+}
 
+void FDestinyMapImportCFGModule::FImportModels(const TSharedRef<FCharmImportSession>& Session, TArray<FString> OutFiles)
+{
+	const FCharmImportSettings& ImportSettings = Session->Settings;
 
-			if (Type == "Terrain")
-			{
-				int ChunkIndex = 0;
-				while (true)
-				{
-					FString ChunkName = ModelName + TEXT("_") + FString::FromInt(ChunkIndex);
-					if (UEditorAssetLibrary::DoesAssetExist(DestinationPath + "/" + ChunkName)) continue;
-					FString SourcePath = FPaths::Combine(AssetsPath, TEXT("Models"), Type, ChunkName + TEXT(".fbx"));
-					if (!FPaths::FileExists(SourcePath)) break;
-					/*
-					if (bSkipExistingAssets)
-					{
-						FString AssetPath = DestinationPath + TEXT("/") + ChunkName + TEXT(".") + ChunkName;
-						if (UEditorAssetLibrary::DoesAssetExist(AssetPath)) {
-							++ChunkIndex;
-							continue;
-						}
-					}
-					*/
+	UTextureFactory* TextureFactory = NewObject<UTextureFactory>();
+	TextureFactory->AddToRoot();
+	TextureFactory->SuppressImportOverwriteDialog();
 
-					FbxFactory->ImportUI->bImportAsSkeletal = false;
-					FbxFactory->ImportUI->bImportMaterials = false;
-					FbxFactory->ImportUI->bImportTextures = false;
-					FbxFactory->ImportUI->SkeletalMeshImportData->ImportUniformScale = fMapScale;
-					FbxFactory->ImportUI->StaticMeshImportData->ImportUniformScale = fMapScale;
-					FbxFactory->ImportUI->StaticMeshImportData->bConvertScene = false;
-					FbxFactory->ImportUI->StaticMeshImportData->bConvertScene = false;
-					FbxFactory->ImportUI->StaticMeshImportData->bCombineMeshes = true;
-					UAutomatedAssetImportData* ImportData = NewObject<UAutomatedAssetImportData>();
-					ImportData->FactoryName = TEXT("FbxFactory");
-					ImportData->Factory = FbxFactory;
-					ImportData->DestinationPath = DestinationPath;
-					ImportData->Filenames.Add(SourcePath);
+	UFbxFactory* FbxFactory = NewObject<UFbxFactory>();
+	FbxFactory->AddToRoot();
+	FbxFactory->ConfigureProperties(); // initializes ImportUI
+	if (!FbxFactory->ImportUI)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FbxFactory->ImportUI is null."));
+		TextureFactory->RemoveFromRoot();
+		FbxFactory->RemoveFromRoot();
+		return;
+	}
 
+	// Same settings for every batch, so ImportUI is set up once per import
+	FbxFactory->ImportUI->bImportAsSkeletal = false;
+	FbxFactory->ImportUI->bImportMaterials = false;
+	FbxFactory->ImportUI->bImportTextures = false;
+	FbxFactory->ImportUI->SkeletalMeshImportData->ImportUniformScale = ImportSettings.fMapScale;
+	FbxFactory->ImportUI->StaticMeshImportData->ImportUniformScale = ImportSettings.fMapScale;
+	FbxFactory->ImportUI->StaticMeshImportData->bConvertScene = false;
+	FbxFactory->ImportUI->StaticMeshImportData->bCombineMeshes = true;
 
+	IAssetTools& AssetTools = FModuleManager::LoadModuleChecked<FAssetToolsModule>("AssetTools").Get();
 
-					FAssetToolsModule& AssetToolsModule = FModuleManager::LoadModuleChecked<FAssetToolsModule>("AssetTools");
-					IAssetTools& AssetTools = AssetToolsModule.Get();
+	if (ImportSettings.bUseInterchange && !Session->InterchangeImporter.IsValid())
+	{
+		Session->InterchangeImporter = MakeShared<FCharmInterchangeImporter>(ImportSettings.fMapScale, ImportSettings.InterchangeMaxInFlight);
+		Session->InterchangeTextureFactory.Reset(NewObject<UTextureFactory>());
+		Session->InterchangeTextureFactory->SuppressImportOverwriteDialog();
+	}
 
-					TArray<UObject*> ImportedAssets = AssetTools.ImportAssetsAutomated(ImportData);
+	TArray<FCharmCFGWork> WorkSet;
+	TArray<FCharmMaterialWork> MaterialWorkSet;
+	FCharmImportJobGraph Graph(TEXT("Model import"));
 
-					if (ImportedAssets.Num() == 0)
-					{
-						UE_LOG(LogTemp, Warning, TEXT("Failed to read JSON value ImportedAssets"));
-					}
-					if (ImportedAssets.Num() > 0 && bImportMaterials == true)
-					{
-						for (UObject* Imported : ImportedAssets)
-						{
+	// Collect: every model, material and pending fbx of all selected CFGs, before any asset is touched
+	const int32 CollectStage = Graph.AddStage(TEXT("Collect"), [this, &Session, &OutFiles, &WorkSet, &MaterialWorkSet]()
+	{
+		// The CFGs of one map are independent files, so they are all parsed at once; asset lookups stay on the game thread
+		TArray<FCharmCFGWork> ParsedWork;
+		ParsedWork.SetNum(OutFiles.Num());
+		TArray<bool> ParseResults;
+		ParseResults.SetNumZeroed(OutFiles.Num());
+		const FCharmImportSettings& ParseSettings = Session->Settings;
+		ParallelFor(OutFiles.Num(), [&OutFiles, &ParsedWork, &ParseResults, &ParseSettings](int32 Index)
+		{
+			ParsedWork[Index].Context.ConfigPath = OutFiles[Index];
+			ParseResults[Index] = FDestinyMapImportCFGModule::FParseCFGWork(ParseSettings, ParsedWork[Index]);
+		});
 
-							FSkeletalMaterial EmptySkeletalMaterialSlot;
-							if (UStaticMesh* StaticMesh = Cast<UStaticMesh>(Imported))
-							{
-								TArray<FStaticMaterial> UpdatedMaterials = StaticMesh->GetStaticMaterials();
-								for (FStaticMaterial& StaticMaterialSlot : UpdatedMaterials)
-								{
-									FinalStaticMaterialSlot = StaticMaterialSlot;
-									FString MaterialRef = StaticMaterialSlot.ImportedMaterialSlotName.ToString();
-									FString TrimmedMaterialRef = MaterialRef;
-									
-									// Strip _ncl1_ suffixes if present
-									int32 NclIndex = MaterialRef.Find(TEXT("_ncl1_"));
-									if (NclIndex != INDEX_NONE)
-									{
-										TrimmedMaterialRef = MaterialRef.Left(NclIndex);
-										FinalStaticMaterialSlot.ImportedMaterialSlotName = FName(*TrimmedMaterialRef);
-										UE_LOG(LogTemp, Warning, TEXT("Detected renamed material: %s → %s"), *MaterialRef, *TrimmedMaterialRef);
-									}
-									
-
-
-									//if (ImportedMaterialRefs.Contains(TrimmedMaterialRef))
-									//	continue;
-
-									ImportedMaterialRefs.Add(TrimmedMaterialRef);
-									FString MaterialJsonPath = FPaths::Combine(AssetsPath, TEXT("Materials"), TrimmedMaterialRef + TEXT(".json"));
-									if (!FPaths::FileExists(MaterialJsonPath)) continue;
-
-									FString JsonContent;
-									if (!FFileHelper::LoadFileToString(JsonContent, *MaterialJsonPath)) continue;
-
-									TSharedPtr<FJsonObject> MaterialJson;
-									TSharedRef<TJsonReader<>> MaterialReader = TJsonReaderFactory<>::Create(JsonContent);
-									if (!FJsonSerializer::Deserialize(MaterialReader, MaterialJson) || !MaterialJson.IsValid()) {
-										UE_LOG(LogTemp, Warning, TEXT("Failed to parse material JSON in %s"), *MaterialJsonPath);
-										continue;
-									}
-
-									if (!MaterialJson->HasTypedField<EJson::Object>(TEXT("Material"))) {
-										UE_LOG(LogTemp, Warning, TEXT("Missing 'Material' object in %s"), *MaterialJsonPath);
-										continue;
-									}
-
-									if (!MaterialJson->GetObjectField("Material")->HasTypedField<EJson::Object>(TEXT("Pixel"))) {
-										UE_LOG(LogTemp, Warning, TEXT("Missing 'Pixel' object under 'Material' in %s"), *MaterialJsonPath);
-										continue;
-									}
-
-									if (!MaterialJson->GetObjectField("Material")->GetObjectField("Pixel")->HasTypedField<EJson::Object>(TEXT("Textures"))) {
-										UE_LOG(LogTemp, Warning, TEXT("Missing 'Textures' object under 'Material.Pixel' in %s"), *MaterialJsonPath);
-										continue;
-									}
-									if (!MaterialJson->HasTypedField<EJson::Object>(TEXT("Material")) ||
-										!MaterialJson->GetObjectField("Material")->HasTypedField<EJson::Object>(TEXT("Pixel")) ||
-										!MaterialJson->GetObjectField("Material")->GetObjectField("Pixel")->HasTypedField<EJson::Object>(TEXT("Textures")))
-									{
-										UE_LOG(LogTemp, Warning, TEXT("Malformed material JSON in %s"), *MaterialJsonPath);
-										continue;
-									}
-
-
-									// Import Textures
-									TMap<FString, TSharedPtr<FJsonValue>> TextureMap = MaterialJson->GetObjectField("Material")->GetObjectField("Pixel")->GetObjectField("Textures")->Values;
-
-
-
-									if (bImportTextures == true && bImportMaterials == false)
-									{
-										FDestinyMapImportCFGModule::FImportTextures(MaterialJson, file, TextureFactory);
-									}
-
-
-									if (bImportMaterials == true)
-									{
-										FDestinyMapImportCFGModule::FImportMaterials(file, StaticMaterialSlot, EmptySkeletalMaterialSlot, MaterialJson, true, TextureFactory);
-										StaticMaterialSlot = FinalStaticMaterialSlot;
-									}
-								}
-								StaticMesh->SetStaticMaterials(UpdatedMaterials);
-								StaticMesh->MarkPackageDirty();
-								StaticMesh->PostEditChange();
-							}
-						}
-					}
+		// A model two CFGs both place into the same destination is queued by the first one only
+		TSet<FString> QueuedSourcePaths;
+		for (int32 Index = 0; Index < ParsedWork.Num(); ++Index)
+		{
+			FCharmCFGWork& Work = ParsedWork[Index];
+			if (!ParseResults[Index] || !FDestinyMapImportCFGModule::FCollectCFGWork(*Session, Work)) continue;
+			Work.PendingSourcePaths.RemoveAll([&QueuedSourcePaths, &Work](const FString& SourcePath)
+			{
+				bool bAlreadyQueued = false;
+				QueuedSourcePaths.Add(Work.DestinationPath / SourcePath, &bAlreadyQueued);
+				return bAlreadyQueued;
+			});
+			WorkSet.Add(MoveTemp(Work));
+		}
 
-					++ChunkIndex;
+		FDestinyMapImportCFGModule::FMergeMaterialWork(WorkSet, MaterialWorkSet);
+	});
 
+	const int32 TexturesStage = Graph.AddStage(TEXT("Textures"), [this, &Session, &ImportSettings, &MaterialWorkSet, TextureFactory]()
+	{
+		if (ImportSettings.bImportTextures == false || (ImportSettings.bMaterialGen == false && ImportSettings.bImportMaterials == true)) return;
+		for (const FCharmMaterialWork& MaterialWork : MaterialWorkSet)
+		{
+			FDestinyMapImportCFGModule::FPrefetchTextures(*Session, MaterialWork.Context, MaterialWork.MaterialRefs.Array(), TextureFactory);
+		}
+	}, { CollectStage });
+
+	// Materials only need their JSON and textures, so they are all built before a single mesh exists
+	const int32 MaterialsStage = Graph.AddStage(TEXT("Materials"), [this, &Session, &ImportSettings, &MaterialWorkSet, TextureFactory]()
+	{
+		if (ImportSettings.bImportMaterials == false) return;
+		Session->bDeferMaterialCompiles = true;
+		int32 ResolvedRefs = 0;
+		TSet<UMaterialInterface*> ResolvedMaterials;
+		for (const FCharmMaterialWork& MaterialWork : MaterialWorkSet)
+		{
+			for (const FString& MaterialRef : MaterialWork.MaterialRefs)
+			{
+				TSharedPtr<FJsonObject> TexturesJson = FDestinyMapImportCFGModule::FLoadMaterialTextures(*Session, MaterialWork.Context.AssetsPath, MaterialRef);
+				if (!TexturesJson.IsValid()) continue;
+				if (UMaterialInterface* Material = FDestinyMapImportCFGModule::FGetOrCreateMaterial(*Session, MaterialWork.Context, MaterialRef, TexturesJson, TextureFactory))
+				{
+					ResolvedMaterials.Add(Material);
+					++ResolvedRefs;
 				}
 			}
-			
-			else
-			{
-
-				if (UEditorAssetLibrary::DoesAssetExist(DestinationPath + "/" + ModelName)) continue;
-				FString SourcePath = FPaths::Combine(AssetsPath, TEXT("Models"), Type, ModelName + TEXT(".fbx"));
-				if (!FPaths::FileExists(SourcePath)) break;
+		}
+		if (ImportSettings.bDedupeMaterials)
+		{
+			UE_LOG(LogTemp, Log, TEXT("%d material refs share %d materials"), ResolvedRefs, ResolvedMaterials.Num());
+		}
+		FDestinyMapImportCFGModule::FFlushMaterialCompiles(*Session);
+	}, { TexturesStage });
 
-				if (!FbxFactory->ImportUI)
+	const int32 MeshesStage = Graph.AddStage(TEXT("Meshes"), [this, &Session, &ImportSettings, &WorkSet, FbxFactory, &AssetTools]()
+	{
+		for (FCharmCFGWork& Work : WorkSet)
+		{
+			if (ImportSettings.bUseInterchange)
+			{
+				// Each file binds its materials as soon as Interchange finished it, the materials already exist by then
+				for (const FString& SourcePath : Work.PendingSourcePaths)
 				{
-					UE_LOG(LogTemp, Error, TEXT("FbxFactory->ImportUI is null."));
-					return;
+					// Weak, the importer lives in the session and a strong reference here would keep the session alive forever
+					TWeakPtr<FCharmImportSession> WeakSession = Session;
+					Session->InterchangeImporter->Enqueue(SourcePath, Work.DestinationPath, [this, WeakSession, Context = Work.Context, SourcePath](const TArray<UObject*>& ImportedObjects)
+					{
+						TSharedPtr<FCharmImportSession> PinnedSession = WeakSession.Pin();
+						if (!PinnedSession.IsValid()) return;
+						for (UObject* ImportedObject : ImportedObjects)
+						{
+							if (!Cast<UStaticMesh>(ImportedObject) && !Cast<USkeletalMesh>(ImportedObject)) continue;
+							FDestinyMapImportCFGModule::FGetImportManifest(*PinnedSession, Context.FolderName).Record(SourcePath, ImportedObject->GetOutermost()->GetName());
+							FDestinyMapImportCFGModule::FNoteImportedAsset(*PinnedSession, ImportedObject->GetOutermost()->GetName());
+						}
+						if (PinnedSession->Settings.bImportMaterials == false) return;
+						FDestinyMapImportCFGModule::FBindImportedMaterials(*PinnedSession, Context, ImportedObjects, PinnedSession->InterchangeTextureFactory.Get());
+					});
 				}
+				continue;
+			}
+
+			for (int32 BatchStart = 0; BatchStart < Work.PendingSourcePaths.Num(); BatchStart += ImportSettings.ModelImportBatchSize)
+			{
+				const int32 BatchNum = FMath::Min(ImportSettings.ModelImportBatchSize, Work.PendingSourcePaths.Num() - BatchStart);
+				UE_LOG(LogTemp, Log, TEXT("Importing %s models %d-%d of %d"), *Work.Context.Type, BatchStart + 1, BatchStart + BatchNum, Work.PendingSourcePaths.Num());
 
-				FbxFactory->ImportUI->bImportAsSkeletal = false;
-				FbxFactory->ImportUI->bImportMaterials = false;
-				FbxFactory->ImportUI->bImportTextures = false;
-				FbxFactory->ImportUI->SkeletalMeshImportData->ImportUniformScale = fMapScale;
-				FbxFactory->ImportUI->StaticMeshImportData->ImportUniformScale = fMapScale;
-				FbxFactory->ImportUI->StaticMeshImportData->bConvertScene = false;
-				FbxFactory->ImportUI->StaticMeshImportData->bConvertScene = false;
-				FbxFactory->ImportUI->StaticMeshImportData->bCombineMeshes = true;
 				UAutomatedAssetImportData* ImportData = NewObject<UAutomatedAssetImportData>();
 				ImportData->FactoryName = TEXT("FbxFactory");
 				ImportData->Factory = FbxFactory;
-				ImportData->DestinationPath = DestinationPath;
-				ImportData->Filenames.Add(SourcePath);
+				ImportData->DestinationPath = Work.DestinationPath;
+				ImportData->Filenames.Append(&Work.PendingSourcePaths[BatchStart], BatchNum);
+				ImportData->bReplaceExisting = true; // pending sources that already have an asset changed since it was imported
 
-				FAssetToolsModule& AssetToolsModule = FModuleManager::LoadModuleChecked<FAssetToolsModule>("AssetTools");
-				IAssetTools& AssetTools = AssetToolsModule.Get();
+				TArray<UObject*> BatchAssets = AssetTools.ImportAssetsAutomated(ImportData);
+				FCharmImportManifest& Manifest = FDestinyMapImportCFGModule::FGetImportManifest(*Session, Work.Context.FolderName);
+				for (UObject* BatchAsset : BatchAssets)
+				{
+					if (!Cast<UStaticMesh>(BatchAsset) && !Cast<USkeletalMesh>(BatchAsset)) continue;
+					Manifest.Record(FPaths::Combine(Work.Context.AssetsPath, TEXT("Models"), Work.Context.Type, BatchAsset->GetName() + TEXT(".fbx")), BatchAsset->GetOutermost()->GetName());
+					FDestinyMapImportCFGModule::FNoteImportedAsset(*Session, BatchAsset->GetOutermost()->GetName());
+				}
+				Work.ImportedAssets.Append(MoveTemp(BatchAssets));
+			}
 
-				TArray<UObject*> ImportedAssets = AssetTools.ImportAssetsAutomated(ImportData);
+			if (Work.PendingSourcePaths.Num() > 0 && Work.ImportedAssets.Num() == 0)
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Failed to read JSON value ImportedAssets"));
+			}
+		}
 
-				if (ImportedAssets.Num() == 0)
+		if (ImportSettings.bUseInterchange)
+		{
+			// The module owns the session until the last file is done, then the manifests are written and it is released
+			RunningSessions.AddUnique(Session);
+			TWeakPtr<FCharmImportSession> WeakSession = Session;
+			Session->InterchangeImporter->SetOnFinished([this, WeakSession]()
+			{
+				if (TSharedPtr<FCharmImportSession> FinishedSession = WeakSession.Pin())
 				{
-					UE_LOG(LogTemp, Warning, TEXT("Failed to read JSON value ImportedAssets"));
+					FDestinyMapImportCFGModule::FFinishPendingImports(FinishedSession.ToSharedRef());
 				}
-				if (ImportedAssets.Num() > 0 && bImportMaterials == true)
-				{
-					for (UObject* Imported : ImportedAssets)
-					{
-						FStaticMaterial EmptyStaticMaterialSlot;
-						FSkeletalMaterial EmptySkeletalMaterialSlot;
-						if (UStaticMesh* StaticMesh = Cast<UStaticMesh>(Imported))
-						{
-							TArray<FStaticMaterial> UpdatedMaterials = StaticMesh->GetStaticMaterials();
-							for (FStaticMaterial& StaticMaterialSlot : UpdatedMaterials)
-							{
-								FinalStaticMaterialSlot = StaticMaterialSlot;
-								FString MaterialRef = StaticMaterialSlot.ImportedMaterialSlotName.ToString();
-								FString TrimmedMaterialRef = MaterialRef;
-								
-								// Strip _ncl1_ suffixes if present
-								int32 NclIndex = MaterialRef.Find(TEXT("_ncl1_"));
-								if (NclIndex != INDEX_NONE)
-								{
-									TrimmedMaterialRef = MaterialRef.Left(NclIndex);
-									FinalStaticMaterialSlot.ImportedMaterialSlotName = FName(*TrimmedMaterialRef);
-									UE_LOG(LogTemp, Warning, TEXT("Detected renamed material: %s → %s"), *MaterialRef, *TrimmedMaterialRef);
-								}
-								
-
-
-								//if (ImportedMaterialRefs.Contains(TrimmedMaterialRef))
-								//	continue;
-
-								ImportedMaterialRefs.Add(TrimmedMaterialRef);
-								FString MaterialJsonPath = FPaths::Combine(AssetsPath, TEXT("Materials"), TrimmedMaterialRef + TEXT(".json"));
-
-								FString JsonContent;
-								if (!FFileHelper::LoadFileToString(JsonContent, *MaterialJsonPath)) continue;
-
-								TSharedPtr<FJsonObject> MaterialJson;
-								TSharedRef<TJsonReader<>> MaterialReader = TJsonReaderFactory<>::Create(JsonContent);
-								if (!FJsonSerializer::Deserialize(MaterialReader, MaterialJson) || !MaterialJson.IsValid()) {
-									UE_LOG(LogTemp, Warning, TEXT("Failed to parse material JSON in %s"), *MaterialJsonPath);
-									continue;
-								}
-
-								if (!MaterialJson->HasTypedField<EJson::Object>(TEXT("Material"))) {
-									UE_LOG(LogTemp, Warning, TEXT("Missing 'Material' object in %s"), *MaterialJsonPath);
-									continue;
-								}
-
-								if (!MaterialJson->GetObjectField("Material")->HasTypedField<EJson::Object>(TEXT("Pixel"))) {
-									UE_LOG(LogTemp, Warning, TEXT("Missing 'Pixel' object under 'Material' in %s"), *MaterialJsonPath);
-									continue;
-								}
-
-								if (!MaterialJson->GetObjectField("Material")->GetObjectField("Pixel")->HasTypedField<EJson::Object>(TEXT("Textures"))) {
-									UE_LOG(LogTemp, Warning, TEXT("Missing 'Textures' object under 'Material.Pixel' in %s"), *MaterialJsonPath);
-									continue;
-								}
-								if (!MaterialJson->HasTypedField<EJson::Object>(TEXT("Material")) ||
-									!MaterialJson->GetObjectField("Material")->HasTypedField<EJson::Object>(TEXT("Pixel")) ||
-									!MaterialJson->GetObjectField("Material")->GetObjectField("Pixel")->HasTypedField<EJson::Object>(TEXT("Textures")))
-								{
-									UE_LOG(LogTemp, Warning, TEXT("Malformed material JSON in %s"), *MaterialJsonPath);
-									continue;
-								}
-
-
-								// Import Textures
-								TMap<FString, TSharedPtr<FJsonValue>> TextureMap = MaterialJson->GetObjectField("Material")->GetObjectField("Pixel")->GetObjectField("Textures")->Values;
-								
-
-
-								if (bImportTextures == true && bImportMaterials == false)
-								{
-									FDestinyMapImportCFGModule::FImportTextures(MaterialJson, file, TextureFactory);
-								}
-
-
-								if (bImportMaterials == true)
-								{
-									FDestinyMapImportCFGModule::FImportMaterials(file, StaticMaterialSlot, EmptySkeletalMaterialSlot, MaterialJson, true, TextureFactory);
-									StaticMaterialSlot = FinalStaticMaterialSlot;
-								}
-							}
-
-							StaticMesh->SetStaticMaterials(UpdatedMaterials);
-							StaticMesh->MarkPackageDirty();
-							StaticMesh->PostEditChange();
-						}
+			});
+			Session->InterchangeImporter->Start();
+		}
+	}, { CollectStage });
+	if (ImportSettings.bUseInterchange)
+	{
+		// Interchange files bind their materials as they finish, so the materials have to exist before the first one starts
+		Graph.AddDependency(MeshesStage, MaterialsStage);
+	}
 
-						else if (USkeletalMesh* SkeletalMesh = Cast<USkeletalMesh>(Imported))
-						{
-							TArray<FSkeletalMaterial> UpdatedMaterials = SkeletalMesh->GetMaterials();
-							for (FSkeletalMaterial& SkeletalMaterialSlot : UpdatedMaterials)
-							{
-								FinalSkeletalMaterialSlot = SkeletalMaterialSlot;
-								FString MaterialRef = SkeletalMaterialSlot.ImportedMaterialSlotName.ToString();
-								
-								FString TrimmedMaterialRef = MaterialRef;
-								
-								// Strip _ncl1_ suffixes if present
-								int32 NclIndex = MaterialRef.Find(TEXT("_ncl1_"));
-								if (NclIndex != INDEX_NONE)
-								{
-									TrimmedMaterialRef = MaterialRef.Left(NclIndex);
-									FinalSkeletalMaterialSlot.ImportedMaterialSlotName = FName(*TrimmedMaterialRef);
-									UE_LOG(LogTemp, Warning, TEXT("Detected renamed material: %s → %s"), *MaterialRef, *TrimmedMaterialRef);
-								}
-								
-								
-								//if (ImportedMaterialRefs.Contains(TrimmedMaterialRef))
-									//continue;
-
-								ImportedMaterialRefs.Add(TrimmedMaterialRef);
-								FString MaterialJsonPath = FPaths::Combine(AssetsPath, TEXT("Materials"), TrimmedMaterialRef + TEXT(".json"));
-
-								FString JsonContent;
-								if (!FFileHelper::LoadFileToString(JsonContent, *MaterialJsonPath)) continue;
-
-								TSharedPtr<FJsonObject> MaterialJson;
-								TSharedRef<TJsonReader<>> MaterialReader = TJsonReaderFactory<>::Create(JsonContent);
-								if (!FJsonSerializer::Deserialize(MaterialReader, MaterialJson) || !MaterialJson.IsValid()) {
-									UE_LOG(LogTemp, Warning, TEXT("Failed to parse material JSON in %s"), *MaterialJsonPath);
-									continue;
-								}
-
-								if (!MaterialJson->HasTypedField<EJson::Object>(TEXT("Material"))) {
-									UE_LOG(LogTemp, Warning, TEXT("Missing 'Material' object in %s"), *MaterialJsonPath);
-									continue;
-								}
-
-								if (!MaterialJson->GetObjectField("Material")->HasTypedField<EJson::Object>(TEXT("Pixel"))) {
-									UE_LOG(LogTemp, Warning, TEXT("Missing 'Pixel' object under 'Material' in %s"), *MaterialJsonPath);
-									continue;
-								}
-
-								if (!MaterialJson->GetObjectField("Material")->GetObjectField("Pixel")->HasTypedField<EJson::Object>(TEXT("Textures"))) {
-									UE_LOG(LogTemp, Warning, TEXT("Missing 'Textures' object under 'Material.Pixel' in %s"), *MaterialJsonPath);
-									continue;
-								}
-								if (!MaterialJson->HasTypedField<EJson::Object>(TEXT("Material")) ||
-									!MaterialJson->GetObjectField("Material")->HasTypedField<EJson::Object>(TEXT("Pixel")) ||
-									!MaterialJson->GetObjectField("Material")->GetObjectField("Pixel")->HasTypedField<EJson::Object>(TEXT("Textures")))
-								{
-									UE_LOG(LogTemp, Warning, TEXT("Malformed material JSON in %s"), *MaterialJsonPath);
-									continue;
-								}
-
-
-								// Import Textures
-								TMap<FString, TSharedPtr<FJsonValue>> TextureMap = MaterialJson->GetObjectField("Material")->GetObjectField("Pixel")->GetObjectField("Textures")->Values;
-								
-
-								if (bImportTextures == true && bImportMaterials == false)
-								{
-									FDestinyMapImportCFGModule::FImportTextures(MaterialJson, file, TextureFactory);
-								}
-
-
-								if (bImportMaterials == true)
-								{
-									FDestinyMapImportCFGModule::FImportMaterials(file, EmptyStaticMaterialSlot, SkeletalMaterialSlot, MaterialJson, false, TextureFactory);
-									SkeletalMaterialSlot = FinalSkeletalMaterialSlot;
-								}
-							}
-							SkeletalMesh->SetMaterials(UpdatedMaterials);
-							SkeletalMesh->MarkPackageDirty();
-							SkeletalMesh->PostEditChange();
-						}
+	Graph.AddStage(TEXT("Bind"), [this, &Session, &ImportSettings, &WorkSet, TextureFactory]()
+	{
+		if (ImportSettings.bImportMaterials == false) return;
+		for (const FCharmCFGWork& Work : WorkSet)
+		{
+			if (Work.ImportedAssets.Num() == 0) continue;
+			FDestinyMapImportCFGModule::FBindImportedMaterials(*Session, Work.Context, Work.ImportedAssets, TextureFactory);
+		}
+	}, { MaterialsStage, MeshesStage });
 
-					}
+	Graph.Run();
 
+	TextureFactory->RemoveFromRoot();
+	FbxFactory->RemoveFromRoot();
+}
 
+bool FDestinyMapImportCFGModule::FParseCFGWork(const FCharmImportSettings& ImportSettings, FCharmCFGWork& Work)
+{
+	FCharmCFGContext& Context = Work.Context;
+	Context.FolderName = FCharmCFGContext::GetFolderName(Context.ConfigPath);
 
+	FCharmCFGHeader Header;
+	FCharmCFGCallbacks Callbacks;
+	Callbacks.OnHeader = [&Header](const FCharmCFGHeader& InHeader)
+	{
+		Header = InHeader;
+		return InHeader.ExportType == TEXT("Map");
+	};
+	Callbacks.OnPart = [&Work](const FString& ModelName, const TArray<FString>& PartMaterialRefs)
+	{
+		if (PartMaterialRefs.Num() == 0)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("SubMap->Values is empty for: %s"), *ModelName);
+			return;
+		}
+		Work.ModelNames.Add(ModelName);
+		Work.MaterialRefs.Append(PartMaterialRefs);
+	};
+	const bool bCFGRead = ImportSettings.bCacheParsedCFG ? FCharmCFGCache::Read(Context.ConfigPath, Callbacks) : FCharmCFGReader::Read(Context.ConfigPath, Callbacks);
+	if (!bCFGRead) return false;
+	if (Header.ExportType != TEXT("Map")) return false;
+
+	Context.Type = Header.Type;
+	Context.AssetsPath = Header.AssetsPath;
+	Work.DestinationPath = TEXT("/Game/") + Context.FolderName + TEXT("/Models/") + Context.Type;
+	return true;
+}
 
+bool FDestinyMapImportCFGModule::FCollectCFGWork(FCharmImportSession& Session, FCharmCFGWork& Work)
+{
+	const FCharmCFGContext& Context = Work.Context;
+	FString TextureImportPath = Session.Settings.GetTexturesPath(Context.FolderName);
 
-				}
+	if (!UEditorAssetLibrary::DoesDirectoryExist(TextureImportPath)) UEditorAssetLibrary::MakeDirectory(TextureImportPath);
 
+	const FCharmAssetsIndex& AssetsIndex = FDestinyMapImportCFGModule::FGetAssetsIndex(Session, Context.AssetsPath);
 
+	if (!UEditorAssetLibrary::DoesDirectoryExist(Work.DestinationPath))
+		UEditorAssetLibrary::MakeDirectory(Work.DestinationPath);
 
+	// Everything this CFG places that has no asset yet or whose fbx changed since, terrain models contribute each chunk
+	FCharmImportManifest& Manifest = FDestinyMapImportCFGModule::FGetImportManifest(Session, Context.FolderName);
+	auto AddIfPending = [this, &Session, &Work, &Manifest, &Context](const FString& AssetName)
+	{
+		FString SourcePath = FPaths::Combine(Context.AssetsPath, TEXT("Models"), Context.Type, AssetName + TEXT(".fbx"));
+		if (FDestinyMapImportCFGModule::FDoesAssetExist(Session, Work.DestinationPath, AssetName) && Manifest.IsUpToDate(SourcePath, Work.DestinationPath + TEXT("/") + AssetName)) return;
+		Work.PendingSourcePaths.Add(MoveTemp(SourcePath));
+	};
+	for (const FString& ModelName : Work.ModelNames)
+	{
+		if (Context.Type == "Terrain")
+		{
+			const int32 ChunkCount = AssetsIndex.GetChunkCount(Context.Type, ModelName);
+			for (int32 ChunkIndex = 0; ChunkIndex < ChunkCount; ++ChunkIndex)
+			{
+				AddIfPending(ModelName + TEXT("_") + FString::FromInt(ChunkIndex));
 			}
 		}
+		else
+		{
+			if (!AssetsIndex.HasModel(Context.Type, ModelName))
+			{
+				if (!FDestinyMapImportCFGModule::FDoesAssetExist(Session, Work.DestinationPath, ModelName))
+				{
+					UE_LOG(LogTemp, Warning, TEXT("Missing model source for %s in %s"), *ModelName, *Context.Type);
+				}
+				continue;
+			}
+			AddIfPending(ModelName);
+		}
 	}
+	return true;
+}
 
+void FDestinyMapImportCFGModule::FMergeMaterialWork(const TArray<FCharmCFGWork>& WorkSet, TArray<FCharmMaterialWork>& OutMaterialWorkSet)
+{
+	// Materials and textures are imported per destination folder, so CFGs writing to the same one share a single entry
+	TMap<FString, int32> MaterialWorkIndices;
+	int32 CFGMaterialRefs = 0;
+	for (const FCharmCFGWork& Work : WorkSet)
+	{
+		const FString Key = Work.Context.FolderName + TEXT("|") + Work.Context.AssetsPath;
+		int32* ExistingIndex = MaterialWorkIndices.Find(Key);
+		if (!ExistingIndex)
+		{
+			FCharmMaterialWork& MaterialWork = OutMaterialWorkSet.AddDefaulted_GetRef();
+			MaterialWork.Context = Work.Context;
+			ExistingIndex = &MaterialWorkIndices.Add(Key, OutMaterialWorkSet.Num() - 1);
+		}
+		OutMaterialWorkSet[*ExistingIndex].MaterialRefs.Append(Work.MaterialRefs);
+		CFGMaterialRefs += Work.MaterialRefs.Num();
+	}
 
+	int32 MergedMaterialRefs = 0;
+	for (const FCharmMaterialWork& MaterialWork : OutMaterialWorkSet)
+	{
+		MergedMaterialRefs += MaterialWork.MaterialRefs.Num();
+	}
+	UE_LOG(LogTemp, Log, TEXT("Collected %d CFGs, %d material references merged into %d materials"), WorkSet.Num(), CFGMaterialRefs, MergedMaterialRefs);
 }
 
-void FDestinyMapImportCFGModule::FImportToMap(TArray<FString> OutFiles)
+void FDestinyMapImportCFGModule::FWaitForPendingImports(FCharmImportSession& Session)
 {
-	
-	for (auto& CFGFile : OutFiles)
+	if (Session.InterchangeImporter.IsValid())
 	{
-		FString ConfigPath = CFGFile;
-		CFGFolderName = FPaths::GetCleanFilename(FPaths::GetPath(ConfigPath)).Replace(TEXT(" "), TEXT("_"));
-		FString FileContents;
-		if (!FFileHelper::LoadFileToString(FileContents, *ConfigPath)) continue;
+		Session.InterchangeImporter->WaitUntilDone();
+		Session.InterchangeImporter.Reset();
+	}
+}
 
-		TSharedPtr<FJsonObject> RootObject;
-		TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(FileContents);
-		if (!FJsonSerializer::Deserialize(Reader, RootObject) || !RootObject.IsValid()) continue;
+void FDestinyMapImportCFGModule::FFinishPendingImports(const TSharedRef<FCharmImportSession>& Session)
+{
+	Session->InterchangeImporter.Reset();
+	for (const TPair<FString, TSharedPtr<FCharmImportManifest>>& Manifest : Session->Manifests)
+	{
+		Manifest.Value->Save();
+	}
+	RunningSessions.Remove(Session);
+}
 
-		// Skip if the export type is not "Map"
-		if (RootObject->GetStringField("ExportType") != TEXT("Map")) continue;
+// Charm renames duplicated slots to <material>_ncl1_<n>, the material JSON is named after the part before it
+static FString TrimMaterialSlotName(const FString& SlotName)
+{
+	int32 NclIndex = SlotName.Find(TEXT("_ncl1_"));
+	if (NclIndex == INDEX_NONE) return SlotName;
 
-		// Extract necessary information
-		FString Type = RootObject->GetStringField("Type");
-		FString FolderName = RootObject->GetStringField("MeshName");
-		FString AssetsPath = RootObject->GetStringField("AssetsPath");
+	FString TrimmedMaterialRef = SlotName.Left(NclIndex);
+	UE_LOG(LogTemp, Warning, TEXT("Detected renamed material: %s → %s"), *SlotName, *TrimmedMaterialRef);
+	return TrimmedMaterialRef;
+}
 
-		// Handle instances (meshes) — only once!
-		TSharedPtr<FJsonObject> InstancesObject = RootObject->GetObjectField("Instances");
-		if (InstancesObject.IsValid())
+void FDestinyMapImportCFGModule::FBindImportedMaterials(FCharmImportSession& Session, const FCharmCFGContext& Context, const TArray<UObject*>& ImportedAssets, UTextureFactory* TextureFactory)
+{
+	for (UObject* Imported : ImportedAssets)
+	{
+		if (UStaticMesh* StaticMesh = Cast<UStaticMesh>(Imported))
 		{
-			for (const auto& InstancePair : InstancesObject->Values)
+			TArray<FStaticMaterial> UpdatedMaterials = StaticMesh->GetStaticMaterials();
+			for (FStaticMaterial& StaticMaterialSlot : UpdatedMaterials)
 			{
+				FString TrimmedMaterialRef = TrimMaterialSlotName(StaticMaterialSlot.ImportedMaterialSlotName.ToString());
+				StaticMaterialSlot.ImportedMaterialSlotName = FName(*TrimmedMaterialRef);
 
-				FString MeshName = InstancePair.Key;
-				const TArray<TSharedPtr<FJsonValue>>& InstanceArray = InstancePair.Value->AsArray();
-				if (Type == TEXT("Terrain"))
-				{
-					int32 TerrainChunkIndex = 0;
-					while (true)
-					{
-						FString SplitMeshName = MeshName + FString::Printf(TEXT("_%d"), TerrainChunkIndex);
-						FString SplitAssetPath = "/Game/" + CFGFolderName + "/Models/" + Type + "/" + SplitMeshName + "." + SplitMeshName;
-						UStaticMesh* TerrainMeshAsset = Cast<UStaticMesh>(StaticLoadObject(UStaticMesh::StaticClass(), nullptr, *SplitAssetPath));
-						if (!TerrainMeshAsset) break;
-						FTransform Transform;
-						AStaticMeshActor* NewActor = GEditor->GetEditorWorldContext().World()->SpawnActor<AStaticMeshActor>(AStaticMeshActor::StaticClass(), Transform);
-						if (NewActor)
-						{
-							NewActor->GetStaticMeshComponent()->SetStaticMesh(TerrainMeshAsset);
-							NewActor->SetActorLabel(SplitMeshName);
-							NewActor->SetFolderPath(FName(*FolderName));
-						}
-						++TerrainChunkIndex;
-					}
-				}
-				else if (Type == TEXT("Decorators"))
-				{
-					UWorld* World = GEditor->GetEditorWorldContext().World();
-					if (!World) return;
+				TSharedPtr<FJsonObject> TexturesJson = FDestinyMapImportCFGModule::FLoadMaterialTextures(Session, Context.AssetsPath, TrimmedMaterialRef);
+				if (!TexturesJson.IsValid()) continue;
 
-					TMap<FString, UHierarchicalInstancedStaticMeshComponent*> MeshToHISM;
+				StaticMaterialSlot.MaterialInterface = FDestinyMapImportCFGModule::FGetOrCreateMaterial(Session, Context, TrimmedMaterialRef, TexturesJson, TextureFactory);
+			}
 
-					AActor* DecoratorContainer = World->SpawnActor<AActor>(AActor::StaticClass());
-					DecoratorContainer->SetActorLabel(TEXT("Decorator_Batch"));
-					DecoratorContainer->SetFolderPath(FName(*FolderName));
+			StaticMesh->SetStaticMaterials(UpdatedMaterials);
+			StaticMesh->MarkPackageDirty();
+			StaticMesh->PostEditChange();
+		}
 
-					for (const TSharedPtr<FJsonValue>& InstanceVal : InstanceArray)
-					{
-						TSharedPtr<FJsonObject> InstanceObj = InstanceVal->AsObject();
-						if (!InstanceObj.IsValid()) continue;
-
-						FVector Location(
-							InstanceObj->GetArrayField("Translation")[0]->AsNumber(),
-							InstanceObj->GetArrayField("Translation")[1]->AsNumber(),
-							InstanceObj->GetArrayField("Translation")[2]->AsNumber()
-						);
-						Location *= fMapScale;
-						FQuat Rotation(
-							InstanceObj->GetArrayField("Rotation")[0]->AsNumber(),
-							InstanceObj->GetArrayField("Rotation")[1]->AsNumber(),
-							InstanceObj->GetArrayField("Rotation")[2]->AsNumber(),
-							InstanceObj->GetArrayField("Rotation")[3]->AsNumber()
-						);
-						FVector Scale(
-							InstanceObj->GetArrayField("Scale")[0]->AsNumber(),
-							InstanceObj->GetArrayField("Scale")[1]->AsNumber(),
-							InstanceObj->GetArrayField("Scale")[2]->AsNumber()
-						);
-						Location.Y *= -1.f;
-						Rotation.Y *= -1.f;
-						Rotation.W *= -1.f;
-						FTransform Transform(Rotation, Location, Scale);
-
-						FString AssetPath = "/Game/" + CFGFolderName + "/Models/" + Type + "/" + MeshName + "." + MeshName;
-						if (UStaticMesh* MeshAsset = Cast<UStaticMesh>(StaticLoadObject(UStaticMesh::StaticClass(), nullptr, *AssetPath)))
-						{
-							if (!MeshToHISM.Contains(MeshName))
-							{
-								UHierarchicalInstancedStaticMeshComponent* HISM = NewObject<UHierarchicalInstancedStaticMeshComponent>(DecoratorContainer);
-								HISM->SetStaticMesh(MeshAsset);
-								HISM->RegisterComponent();
-								HISM->AttachToComponent(DecoratorContainer->GetRootComponent(), FAttachmentTransformRules::KeepRelativeTransform);
-								MeshToHISM.Add(MeshName, HISM);
-							}
-
-							MeshToHISM[MeshName]->AddInstance(Transform);
-						}
-					}
-				}
-				else
-				{
-					for (const TSharedPtr<FJsonValue>& InstanceVal : InstanceArray)
-					{
-						TSharedPtr<FJsonObject> InstanceObj = InstanceVal->AsObject();
-						if (!InstanceObj.IsValid()) continue;
-
-						FVector Location(
-							InstanceObj->GetArrayField("Translation")[0]->AsNumber(),
-							InstanceObj->GetArrayField("Translation")[1]->AsNumber(),
-							InstanceObj->GetArrayField("Translation")[2]->AsNumber()
-						);
-						Location *= fMapScale;
-						FQuat Rotation(
-							InstanceObj->GetArrayField("Rotation")[0]->AsNumber(),
-							InstanceObj->GetArrayField("Rotation")[1]->AsNumber(),
-							InstanceObj->GetArrayField("Rotation")[2]->AsNumber(),
-							InstanceObj->GetArrayField("Rotation")[3]->AsNumber()
-						);
-						FVector Scale(
-							InstanceObj->GetArrayField("Scale")[0]->AsNumber(),
-							InstanceObj->GetArrayField("Scale")[1]->AsNumber(),
-							InstanceObj->GetArrayField("Scale")[2]->AsNumber()
-						);
-						Location.Y *= -1.f;
-						Rotation.Y *= -1.f;
-						Rotation.W *= -1.f;
-						FTransform Transform(Rotation, Location, Scale);
-
-						FString AssetPath = "/Game/" + CFGFolderName + "/Models/" + Type + "/" + MeshName + "." + MeshName;
-						if (UStaticMesh* MeshAsset = Cast<UStaticMesh>(StaticLoadObject(UStaticMesh::StaticClass(), nullptr, *AssetPath)))
-						{
-							if (MeshAsset)
-							{
-								AStaticMeshActor* NewActor = GEditor->GetEditorWorldContext().World()->SpawnActor<AStaticMeshActor>(AStaticMeshActor::StaticClass(), Transform);
-								if (NewActor)
-								{
-									NewActor->GetStaticMeshComponent()->SetStaticMesh(MeshAsset);
-									NewActor->SetActorLabel(MeshName);
-									NewActor->SetFolderPath(FName(*FolderName));
-								}
-							}
-						}
+		else if (USkeletalMesh* SkeletalMesh = Cast<USkeletalMesh>(Imported))
+		{
+			TArray<FSkeletalMaterial> UpdatedMaterials = SkeletalMesh->GetMaterials();
+			for (FSkeletalMaterial& SkeletalMaterialSlot : UpdatedMaterials)
+			{
+				FString TrimmedMaterialRef = TrimMaterialSlotName(SkeletalMaterialSlot.ImportedMaterialSlotName.ToString());
+				SkeletalMaterialSlot.ImportedMaterialSlotName = FName(*TrimmedMaterialRef);
 
-						if (USkeletalMesh* MeshAsset = Cast<USkeletalMesh>(StaticLoadObject(USkeletalMesh::StaticClass(), nullptr, *AssetPath)))
-						{
-							if (MeshAsset)
-							{
-								ASkeletalMeshActor* NewActor = GEditor->GetEditorWorldContext().World()->SpawnActor<ASkeletalMeshActor>(ASkeletalMeshActor::StaticClass(), Transform);
-								if (NewActor)
-								{
-									NewActor->GetSkeletalMeshComponent()->SetSkeletalMesh(MeshAsset);
-									NewActor->SetActorLabel(MeshName);
-									NewActor->SetFolderPath(FName(*FolderName));
-								}
-							}
-						}
-					}
-				}
+				TSharedPtr<FJsonObject> TexturesJson = FDestinyMapImportCFGModule::FLoadMaterialTextures(Session, Context.AssetsPath, TrimmedMaterialRef);
+				if (!TexturesJson.IsValid()) continue;
+
+				SkeletalMaterialSlot.MaterialInterface = FDestinyMapImportCFGModule::FGetOrCreateMaterial(Session, Context, TrimmedMaterialRef, TexturesJson, TextureFactory);
 			}
+			SkeletalMesh->SetMaterials(UpdatedMaterials);
+			SkeletalMesh->MarkPackageDirty();
+			SkeletalMesh->PostEditChange();
 		}
 
-
 	}
 }
 
-
-void FDestinyMapImportCFGModule::FImportTextures(TSharedPtr<FJsonObject> MaterialJson, FString ConfigPath, UTextureFactory* TextureFactory)
+TSharedPtr<FJsonObject> FDestinyMapImportCFGModule::FLoadMaterialTextures(FCharmImportSession& Session, const FString& AssetsPath, FString MaterialRef)
 {
-	CFGFolderName = FPaths::GetCleanFilename(FPaths::GetPath(ConfigPath)).Replace(TEXT(" "), TEXT("_"));
+	FString MaterialJsonPath = FPaths::Combine(AssetsPath, TEXT("Materials"), MaterialRef + TEXT(".json"));
+	if (const TSharedPtr<FJsonObject>* CachedTextures = Session.MaterialTexturesCache.Find(MaterialJsonPath))
+	{
+		return *CachedTextures;
+	}
 
-	FString FileContents;
-	if (!FFileHelper::LoadFileToString(FileContents, *ConfigPath)) return;
+	// Failures are cached as null too so a missing or malformed JSON is only read and reported once
+	TSharedPtr<FJsonObject>& TexturesJson = Session.MaterialTexturesCache.Add(MaterialJsonPath);
 
-	TSharedPtr<FJsonObject> RootObject;
-	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(FileContents);
-	if (!FJsonSerializer::Deserialize(Reader, RootObject) || !RootObject.IsValid()) return;
-	if (RootObject->GetStringField("ExportType") != TEXT("Map")) return;
+	if (!FDestinyMapImportCFGModule::FGetAssetsIndex(Session, AssetsPath).HasMaterial(MaterialRef)) return nullptr;
 
-	FString Type = RootObject->GetStringField("Type");
-	FString AssetsPath = RootObject->GetStringField("AssetsPath");
-	TSharedPtr<FJsonObject> Parts = RootObject->GetObjectField("Parts");
+	FString JsonContent;
+	if (!FFileHelper::LoadFileToString(JsonContent, *MaterialJsonPath)) return nullptr;
 
-	FString DestinationPath = TEXT("/Game/") + CFGFolderName + TEXT("/Models/") + Type;
+	TSharedPtr<FJsonObject> MaterialJson;
+	TSharedRef<TJsonReader<>> MaterialReader = TJsonReaderFactory<>::Create(JsonContent);
+	if (!FJsonSerializer::Deserialize(MaterialReader, MaterialJson) || !MaterialJson.IsValid()) {
+		UE_LOG(LogTemp, Warning, TEXT("Failed to parse material JSON in %s"), *MaterialJsonPath);
+		return nullptr;
+	}
 
-	for (auto& Pair : Parts->Values)
-	{
-		FString ModelName = Pair.Key;
-		TSharedPtr<FJsonObject> SubMap = Pair.Value->AsObject();
+	if (!MaterialJson->HasTypedField<EJson::Object>(TEXT("Material"))) {
+		UE_LOG(LogTemp, Warning, TEXT("Missing 'Material' object in %s"), *MaterialJsonPath);
+		return nullptr;
+	}
 
-		for (auto& MaterialPair : SubMap->Values)
-		{
-			FString MaterialRef = MaterialPair.Value->AsString(); // e.g., "8EE5FF80"
-			FString MaterialJsonPath = FPaths::Combine(AssetsPath, TEXT("Materials"), MaterialRef + TEXT(".json"));
+	if (!MaterialJson->GetObjectField("Material")->HasTypedField<EJson::Object>(TEXT("Pixel"))) {
+		UE_LOG(LogTemp, Warning, TEXT("Missing 'Pixel' object under 'Material' in %s"), *MaterialJsonPath);
+		return nullptr;
+	}
 
-			if (!FPaths::FileExists(MaterialJsonPath))
-			{
-				UE_LOG(LogTemp, Warning, TEXT("Missing material JSON file: %s"), *MaterialJsonPath);
-				continue;
-			}
+	if (!MaterialJson->GetObjectField("Material")->GetObjectField("Pixel")->HasTypedField<EJson::Object>(TEXT("Textures"))) {
+		UE_LOG(LogTemp, Warning, TEXT("Missing 'Textures' object under 'Material.Pixel' in %s"), *MaterialJsonPath);
+		return nullptr;
+	}
+
+	TexturesJson = MaterialJson->GetObjectField("Material")->GetObjectField("Pixel")->GetObjectField("Textures");
+	return TexturesJson;
+}
+
+void FDestinyMapImportCFGModule::FImportToMap(FCharmImportSession& Session, TArray<FString> OutFiles)
+{
+	
+	for (auto& CFGFile : OutFiles)
+	{
+		FCharmCFGContext Context;
+		Context.ConfigPath = CFGFile;
+		Context.FolderName = FCharmCFGContext::GetFolderName(CFGFile);
+
+		// Instances are placed as the reader streams them, one mesh at a time
+		FString OutlinerFolder;
+		FCharmCFGCallbacks Callbacks;
+		Callbacks.OnHeader = [&Context, &OutlinerFolder](const FCharmCFGHeader& Header)
+		{
+			// Skip if the export type is not "Map"
+			Context.Type = Header.Type;
+			Context.AssetsPath = Header.AssetsPath;
+			OutlinerFolder = Header.MeshName;
+			return Header.ExportType == TEXT("Map");
+		};
+		Callbacks.OnInstances = [this, &Session, &Context, &OutlinerFolder](const FString& MeshName, FCharmInstanceBuffer& InstanceBuffer)
+		{
+			FDestinyMapImportCFGModule::FPlaceMeshInstances(Session, Context, OutlinerFolder, MeshName, InstanceBuffer);
+		};
+		if (Session.Settings.bCacheParsedCFG)
+		{
+			FCharmCFGCache::Read(Context.ConfigPath, Callbacks);
+		}
+		else
+		{
+			FCharmCFGReader::Read(Context.ConfigPath, Callbacks);
+		}
+	}
+}
 
-			FString JsonContent;
-			if (FFileHelper::LoadFileToString(JsonContent, *MaterialJsonPath))
+void FDestinyMapImportCFGModule::FPlaceMeshInstances(FCharmImportSession& Session, const FCharmCFGContext& Context, const FString& OutlinerFolder, const FString& MeshName, FCharmInstanceBuffer& InstanceBuffer)
+{
+	const FString& Type = Context.Type;
+	if (Type == TEXT("Terrain"))
+	{
+		int32 TerrainChunkIndex = 0;
+		while (true)
+		{
+			FString SplitMeshName = MeshName + FString::Printf(TEXT("_%d"), TerrainChunkIndex);
+			FString SplitAssetPath = "/Game/" + Context.FolderName + "/Models/" + Type + "/" + SplitMeshName + "." + SplitMeshName;
+			UStaticMesh* TerrainMeshAsset = Cast<UStaticMesh>(StaticLoadObject(UStaticMesh::StaticClass(), nullptr, *SplitAssetPath));
+			if (!TerrainMeshAsset) break;
+			FTransform Transform;
+			AStaticMeshActor* NewActor = GEditor->GetEditorWorldContext().World()->SpawnActor<AStaticMeshActor>(AStaticMeshActor::StaticClass(), Transform, FDestinyMapImportCFGModule::FMakePlacementParameters(Session, SplitMeshName, OutlinerFolder, Type));
+			if (NewActor)
 			{
+				NewActor->GetStaticMeshComponent()->SetStaticMesh(TerrainMeshAsset);
 			}
+			++TerrainChunkIndex;
+		}
+	}
+	else
+	{
+		// Resolve the mesh once per key, not once per placement, and remember whether it is static or skeletal
+		FString AssetPath = "/Game/" + Context.FolderName + "/Models/" + Type + "/" + MeshName + "." + MeshName;
+		UObject* MeshObject = StaticLoadObject(UObject::StaticClass(), nullptr, *AssetPath);
+		UStaticMesh* StaticMeshAsset = Cast<UStaticMesh>(MeshObject);
+		USkeletalMesh* SkeletalMeshAsset = Cast<USkeletalMesh>(MeshObject);
+		if (!StaticMeshAsset && !SkeletalMeshAsset)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("No static or skeletal mesh found at %s"), *AssetPath);
+			return;
+		}
 
-			FString TextureImportPath = TEXT("/Game/") + CFGFolderName + TEXT("/Textures");
-			TMap<FString, TSharedPtr<FJsonValue>> TextureMap = MaterialJson->GetObjectField("Material")
-				->GetObjectField("Pixel")
-				->GetObjectField("Textures")->Values;
+		UWorld* World = GEditor->GetEditorWorldContext().World();
+		if (!World) return;
 
-			for (const auto& TextureEntry : TextureMap)
-			{
-				TSharedPtr<FJsonObject> TextureObj = TextureEntry.Value->AsObject();
-				FString Hash = TextureObj->GetStringField("Hash");
-				FString Format = TextureObj->GetStringField("Format");
-				FString Colorspace = TextureObj->GetStringField("Colorspace");
+		// Decorators always share one HISM per mesh, other static meshes do once they are placed at least Session.Settings.InstancingThreshold times
+		const bool bDecoratorBatch = Type == TEXT("Decorators") && StaticMeshAsset;
+		const bool bMeshBatch = Session.Settings.bInstanceMeshes && StaticMeshAsset && InstanceBuffer.Num() >= Session.Settings.InstancingThreshold;
+		const FString BatchLabel = bDecoratorBatch ? FString(TEXT("Decorator_Batch")) : MeshName + TEXT("_Batch");
 
-				FString TextureFormat;
-				FString TextureSourcePath;
+		InstanceBuffer.ConvertCharmToUnreal(Session.Settings.fMapScale);
+		TArray<FTransform> Transforms;
+		InstanceBuffer.ToTransforms(Transforms);
 
-				FString PNGPath = FPaths::Combine(AssetsPath, TEXT("Textures"), Hash + TEXT(".png"));
-				FString TGAPath = FPaths::Combine(AssetsPath, TEXT("Textures"), Hash + TEXT(".tga"));
-				FString TifPath = FPaths::Combine(AssetsPath, TEXT("Textures"), Hash + TEXT(".tif"));
-				FString TiffPath = FPaths::Combine(AssetsPath, TEXT("Textures"), Hash + TEXT(".tiff"));
+		// Decorators are bucketed on their own finer grid, other batches are only split into World Partition cells
+		float CellSize = 0.f;
+		bool bSplitHeight = false;
+		if (bDecoratorBatch && Session.Settings.DecoratorCellSize > 0.f)
+		{
+			CellSize = FMath::Max(Session.Settings.DecoratorCellSize, 100.f);
+			bSplitHeight = Session.Settings.bDecoratorCells3D;
+		}
+		else if ((bDecoratorBatch || bMeshBatch) && Session.Settings.bWorldPartitionOutput && World->IsPartitionedWorld())
+		{
+			CellSize = FMath::Max(Session.Settings.WorldPartitionCellSize, 100.f);
+		}
 
-				switch (SelectedFormat)
+		if (CellSize > 0.f)
+		{
+			// One container per grid cell and mesh: each HISM culls and rebuilds its cluster tree over a small area, and World Partition streams it with the cell it sits in
+			for (const TPair<FIntVector, TArray<FTransform>>& Cell : SplitIntoGridCells(Transforms, CellSize, bSplitHeight))
+			{
+				const FVector CellCenter((Cell.Key.X + 0.5) * CellSize, (Cell.Key.Y + 0.5) * CellSize, bSplitHeight ? (Cell.Key.Z + 0.5) * CellSize : 0.0);
+				const FString CellLabel = bSplitHeight
+					? FString::Printf(TEXT("%s_%d_%d_%d"), *BatchLabel, Cell.Key.X, Cell.Key.Y, Cell.Key.Z)
+					: FString::Printf(TEXT("%s_%d_%d"), *BatchLabel, Cell.Key.X, Cell.Key.Y);
+				SpawnInstancedBatch(World, StaticMeshAsset, CellCenter, Cell.Value, FDestinyMapImportCFGModule::FMakePlacementParameters(Session, CellLabel, OutlinerFolder, Type));
+			}
+		}
+		else if (bDecoratorBatch || bMeshBatch)
+		{
+			SortByMortonOrder(Transforms);
+			SpawnInstancedBatch(World, StaticMeshAsset, FVector::ZeroVector, Transforms, FDestinyMapImportCFGModule::FMakePlacementParameters(Session, BatchLabel, OutlinerFolder, Type));
+		}
+		else
+		{
+			// Every placement of this mesh gets the same label, folder and data layer, so one set of spawn parameters serves them all
+			const FActorSpawnParameters SpawnParameters = FDestinyMapImportCFGModule::FMakePlacementParameters(Session, MeshName, OutlinerFolder, Type);
+			for (const FTransform& Transform : Transforms)
+			{
+				if (StaticMeshAsset)
 				{
-				case ETextureFormat::TF_PNG:
-					if (FPaths::FileExists(PNGPath))
+					AStaticMeshActor* NewActor = World->SpawnActor<AStaticMeshActor>(AStaticMeshActor::StaticClass(), Transform, SpawnParameters);
+					if (NewActor)
 					{
-						TextureFormat = ".png";
-						TextureSourcePath = PNGPath;
+						NewActor->GetStaticMeshComponent()->SetStaticMesh(StaticMeshAsset);
 					}
-					else
+				}
+				else
+				{
+					ASkeletalMeshActor* NewActor = World->SpawnActor<ASkeletalMeshActor>(ASkeletalMeshActor::StaticClass(), Transform, SpawnParameters);
+					if (NewActor)
 					{
-						continue;
+						NewActor->GetSkeletalMeshComponent()->SetSkeletalMesh(SkeletalMeshAsset);
 					}
-					break;
+				}
+			}
+		}
+	}
+}
 
-				case ETextureFormat::TF_TGA:
-					if (FPaths::FileExists(TGAPath))
-					{
-						TextureFormat = ".tga";
-						TextureSourcePath = TGAPath;
-					}
-					else
-					{
-						continue;
-					}
-					break;
 
-				case ETextureFormat::TF_TIF:
-					if (FPaths::FileExists(TiffPath))
-					{
-						TextureFormat = ".tiff";
-						TextureSourcePath = TiffPath;
-					}
-					else if (FPaths::FileExists(TifPath))
-					{
-						TextureFormat = ".tif";
-						TextureSourcePath = TifPath;
-					}
-					else
-					{
-						continue;
-					}
-					break;
+void FDestinyMapImportCFGModule::FPrefetchTextures(FCharmImportSession& Session, const FCharmCFGContext& Context, const TArray<FString>& MaterialRefs, UTextureFactory* TextureFactory)
+{
+	FString TextureImportPath = Session.Settings.GetTexturesPath(Context.FolderName);
+	const FCharmAssetsIndex& AssetsIndex = FDestinyMapImportCFGModule::FGetAssetsIndex(Session, Context.AssetsPath);
+	FCharmImportManifest& Manifest = FDestinyMapImportCFGModule::FGetImportManifest(Session, Context.FolderName);
 
-				case ETextureFormat::TF_Auto:
-				default:
-					if (FPaths::FileExists(TGAPath))
-					{
-						TextureFormat = ".tga";
-						TextureSourcePath = TGAPath;
-					}
-					else if (FPaths::FileExists(PNGPath))
-					{
-						TextureFormat = ".png";
-						TextureSourcePath = PNGPath;
-					}
-					else if (FPaths::FileExists(TiffPath))
-					{
-						TextureFormat = ".tiff";
-						TextureSourcePath = TiffPath;
-					}
-					else if (FPaths::FileExists(TifPath))
-					{
-						TextureFormat = ".tif";
-						TextureSourcePath = TifPath;
-					}
-					else
-					{
-						continue;
-					}
-					break;
-				}
+	// Gather every texture the CFG's materials reference before any model is imported
+	TArray<FCharmTextureRequest> Requests;
+	for (const FString& MaterialRef : MaterialRefs)
+	{
+		TSharedPtr<FJsonObject> TexturesJson = FDestinyMapImportCFGModule::FLoadMaterialTextures(Session, Context.AssetsPath, MaterialRef);
+		if (!TexturesJson.IsValid()) continue;
 
+		for (const auto& TextureEntry : TexturesJson->Values)
+		{
+			TSharedPtr<FJsonObject> TextureObj = TextureEntry.Value->AsObject();
+			if (!TextureObj.IsValid()) continue;
+			FString Hash = TextureObj->GetStringField("Hash");
+
+			FString TextureAssetPath = TextureImportPath + TEXT("/") + Hash;
+			bool bAlreadyHandled = false;
+			Session.ImportedTextureHashes.Add(TextureAssetPath, &bAlreadyHandled);
+			if (bAlreadyHandled) continue;
+
+			FString SourcePath = AssetsIndex.FindTextureSource(Hash, Session.Settings.SelectedFormat);
+			if (SourcePath.IsEmpty()) continue;
+			if (FDestinyMapImportCFGModule::FDoesAssetExist(Session, TextureImportPath, Hash) && Manifest.IsUpToDate(SourcePath, TextureAssetPath)) continue;
+
+			FCharmTextureRequest& Request = Requests.AddDefaulted_GetRef();
+			Request.Hash = Hash;
+			Request.SourcePath = MoveTemp(SourcePath);
+			Request.Format = TextureObj->GetStringField("Format");
+			Request.bSRGB = TextureObj->GetStringField("Colorspace") == TEXT("sRGB");
+		}
+	}
+	if (Requests.Num() == 0) return;
 
-				// For PNG or TGA we still need to generate path
-				if (TextureSourcePath.IsEmpty() && !TextureFormat.IsEmpty())
-				{
-					TextureSourcePath = FPaths::Combine(AssetsPath, TEXT("Textures"), Hash + TextureFormat);
-					if (!FPaths::FileExists(TextureSourcePath)) continue;
-				}
+	UE_LOG(LogTemp, Log, TEXT("Decoding %d textures for %s"), Requests.Num(), *Context.FolderName);
+	TArray<FCharmTextureRequest> Undecoded;
+	FCharmTextureDecoder::DecodeAll(Requests, Session.Settings.TexturePrefetchDepth, [&Session, &Manifest, &TextureImportPath, &Undecoded](FCharmDecodedTexture& Decoded)
+	{
+		FString TextureAssetPath = TextureImportPath + TEXT("/") + Decoded.Request.Hash;
+		if (!FCharmTextureDecoder::CreateTexture(TextureAssetPath, Decoded))
+		{
+			Undecoded.Add(MoveTemp(Decoded.Request));
+			return;
+		}
+		Manifest.Record(Decoded.Request.SourcePath, TextureAssetPath);
+		FDestinyMapImportCFGModule::FNoteImportedAsset(Session, TextureAssetPath);
+	});
 
-				// Proceed to import
-				UAutomatedAssetImportData* TextureImportData = NewObject<UAutomatedAssetImportData>();
-				TextureImportData->FactoryName = TEXT("TextureFactory");
-				TextureImportData->Factory = TextureFactory;
-				TextureImportData->DestinationPath = TextureImportPath;
-				TextureImportData->Filenames.Add(TextureSourcePath);
+	// Sources the decoder can't handle go through the TextureFactory here, the material stages may never ask for them
+	for (const FCharmTextureRequest& Request : Undecoded)
+	{
+		FDestinyMapImportCFGModule::FImportTextureSource(Session, Manifest, TextureImportPath, Request, TextureFactory);
+	}
+}
 
-				FAssetToolsModule& TextureAssetToolsModule = FModuleManager::LoadModuleChecked<FAssetToolsModule>("AssetTools");
-				TArray<UObject*> ImportedTextures = TextureAssetToolsModule.Get().ImportAssetsAutomated(TextureImportData);
+void FDestinyMapImportCFGModule::FImportTextures(FCharmImportSession& Session, const FCharmCFGContext& Context, TSharedPtr<FJsonObject> TexturesJson, UTextureFactory* TextureFactory)
+{
+	FString TextureImportPath = Session.Settings.GetTexturesPath(Context.FolderName);
+	const FCharmAssetsIndex& AssetsIndex = FDestinyMapImportCFGModule::FGetAssetsIndex(Session, Context.AssetsPath);
+	FCharmImportManifest& Manifest = FDestinyMapImportCFGModule::FGetImportManifest(Session, Context.FolderName);
 
-				for (UObject* ImportedObj : ImportedTextures)
-				{
-					if (UTexture2D* ImportedTex = Cast<UTexture2D>(ImportedObj))
-					{
-						ImportedTex->SRGB = (Colorspace == TEXT("sRGB"));
-						if (Format == "BC1_UNORM_SRGB")	ImportedTex->CompressionSettings = TC_Default;
-						else if (Format == "BC7_UNORM_SRGB" || Format == "BC7_UNORM")	ImportedTex->CompressionSettings = TC_BC7;
-						else if (Format == "BC5_UNORM") ImportedTex->CompressionSettings = TC_Normalmap;
-						else if (Format == "BC4_UNORM")	ImportedTex->CompressionSettings = TC_Alpha;
-						else
-						{
-							UE_LOG(LogTemp, Warning, TEXT("Unknown Texture Format for Texture %s: %s"), *Hash, *Format);
-							ImportedTex->CompressionSettings = TC_Default;
-						}
-						ImportedTex->PostEditChange();
-						ImportedTex->MarkPackageDirty();
-					}
-				}
-			}
+	for (const auto& TextureEntry : TexturesJson->Values)
+	{
+		TSharedPtr<FJsonObject> TextureObj = TextureEntry.Value->AsObject();
+		if (!TextureObj.IsValid()) continue;
+		FString Hash = TextureObj->GetStringField("Hash");
+
+		// Each hash is handled at most once per session, whether it was imported or already existed
+		FString TextureAssetPath = TextureImportPath + TEXT("/") + Hash;
+		bool bAlreadyHandled = false;
+		Session.ImportedTextureHashes.Add(TextureAssetPath, &bAlreadyHandled);
+		if (bAlreadyHandled) continue;
+
+		FString TextureSourcePath = AssetsIndex.FindTextureSource(Hash, Session.Settings.SelectedFormat);
+		if (TextureSourcePath.IsEmpty()) continue;
+		if (FDestinyMapImportCFGModule::FDoesAssetExist(Session, TextureImportPath, Hash) && Manifest.IsUpToDate(TextureSourcePath, TextureAssetPath)) continue;
+
+		FCharmTextureRequest Request;
+		Request.Hash = Hash;
+		Request.SourcePath = MoveTemp(TextureSourcePath);
+		Request.Format = TextureObj->GetStringField("Format");
+		Request.bSRGB = TextureObj->GetStringField("Colorspace") == TEXT("sRGB");
+		FDestinyMapImportCFGModule::FImportTextureSource(Session, Manifest, TextureImportPath, Request, TextureFactory);
+	}
+}
+
+void FDestinyMapImportCFGModule::FImportTextureSource(FCharmImportSession& Session, FCharmImportManifest& Manifest, const FString& TextureImportPath, const FCharmTextureRequest& Request, UTextureFactory* TextureFactory)
+{
+	FString TextureAssetPath = TextureImportPath + TEXT("/") + Request.Hash;
 
+	UAutomatedAssetImportData* TextureImportData = NewObject<UAutomatedAssetImportData>();
+	TextureImportData->FactoryName = TEXT("TextureFactory");
+	TextureImportData->Factory = TextureFactory;
+	TextureImportData->DestinationPath = TextureImportPath;
+	TextureImportData->Filenames.Add(Request.SourcePath);
+	TextureImportData->bReplaceExisting = true;
 
+	FAssetToolsModule& TextureAssetToolsModule = FModuleManager::LoadModuleChecked<FAssetToolsModule>("AssetTools");
+	TArray<UObject*> ImportedTextures = TextureAssetToolsModule.Get().ImportAssetsAutomated(TextureImportData);
 
+	for (UObject* ImportedObj : ImportedTextures)
+	{
+		if (UTexture2D* ImportedTex = Cast<UTexture2D>(ImportedObj))
+		{
+			ImportedTex->SRGB = Request.bSRGB;
+			ImportedTex->CompressionSettings = FCharmTextureDecoder::GetCompressionSettings(Request.Hash, Request.Format);
+			ImportedTex->PostEditChange();
+			ImportedTex->MarkPackageDirty();
+			Manifest.Record(Request.SourcePath, TextureAssetPath);
+			FDestinyMapImportCFGModule::FNoteImportedAsset(Session, TextureAssetPath);
 		}
 	}
 }
@@ -1323,72 +1669,94 @@ void FDestinyMapImportCFGModule::FImportTextures(TSharedPtr<FJsonObject> Materia
 	TC_MAX,
 */
 
-void FDestinyMapImportCFGModule::FImportMaterials(FString ConfigPath, FStaticMaterial& StaticMaterialSlot, FSkeletalMaterial& SkeletalMaterialSlot, TSharedPtr<FJsonObject> MaterialJson, bool isStaticMesh, UTextureFactory* TextureFactory)
+// Generated materials are built from nothing but their textures' hashes and colorspaces in JSON order,
+// so materials that agree on those are identical apart from their name
+static FString GetMaterialSignatureName(const TSharedPtr<FJsonObject>& TexturesJson)
 {
-	CFGFolderName = FPaths::GetCleanFilename(FPaths::GetPath(ConfigPath)).Replace(TEXT(" "), TEXT("_"));
-	FString MaterialName;
-	if (isStaticMesh == true)
+	FString Signature;
+	for (const auto& TextureEntry : TexturesJson->Values)
 	{
-		MaterialName = StaticMaterialSlot.ImportedMaterialSlotName.ToString();
-		
-		UE_LOG(LogTemp, Warning, TEXT("FImportMaterials called with slot name: %s"), *StaticMaterialSlot.ImportedMaterialSlotName.ToString());
+		TSharedPtr<FJsonObject> TextureObj = TextureEntry.Value->AsObject();
+		if (!TextureObj.IsValid()) continue;
+		Signature += TextureObj->GetStringField("Hash") + TEXT(":") + TextureObj->GetStringField("Colorspace") + TEXT(";");
 	}
-	else
+	return TEXT("MS_") + FMD5::HashAnsiString(*Signature).Left(16);
+}
+
+UMaterialInterface* FDestinyMapImportCFGModule::FGetOrCreateMaterial(FCharmImportSession& Session, const FCharmCFGContext& Context, FString MaterialRef, TSharedPtr<FJsonObject> TexturesJson, UTextureFactory* TextureFactory)
+{
+	// With dedupe on, every material ref of one texture set resolves to the same MS_<signature> asset
+	FString MaterialName = Session.Settings.bDedupeMaterials ? GetMaterialSignatureName(TexturesJson) : MaterialRef;
+	FString MaterialsPath = Session.Settings.GetMaterialsPath(Context.FolderName);
+	FString MatPath = MaterialsPath + "/" + MaterialName + "." + MaterialName;
+
+	// Every slot after the first one referencing this material reuses what this session already built or loaded
+	const TWeakObjectPtr<UMaterialInterface>* CachedMaterial = Session.MaterialCache.Find(MatPath);
+	if (CachedMaterial && CachedMaterial->IsValid())
 	{
-		MaterialName = SkeletalMaterialSlot.ImportedMaterialSlotName.ToString();
+		return CachedMaterial->Get();
 	}
 
-	FString TrimmedMaterialRef = MaterialName;
-	int32 NclIndex = MaterialName.Find(TEXT("_ncl1_"));
-	if (NclIndex != INDEX_NONE)
+	UMaterialInterface* NewMaterial = nullptr;
+	UObject* LoadedObj = FDestinyMapImportCFGModule::FDoesAssetExist(Session, MaterialsPath, MaterialName) ? UEditorAssetLibrary::LoadAsset(MatPath) : nullptr;
+
+	// A material whose JSON changed since it was built is rebuilt in place, so meshes keep referencing it
+	FCharmImportManifest& Manifest = FDestinyMapImportCFGModule::FGetImportManifest(Session, Context.FolderName);
+	const FString MaterialJsonPath = FPaths::Combine(Context.AssetsPath, TEXT("Materials"), MaterialRef + TEXT(".json"));
+	const FString MaterialPackagePath = MaterialsPath + "/" + MaterialName;
+	UMaterial* StaleMaterial = nullptr;
+	UMaterialInstanceConstant* StaleInstance = nullptr;
+	if (LoadedObj && !Manifest.IsUpToDate(MaterialJsonPath, MaterialPackagePath))
 	{
-		TrimmedMaterialRef = MaterialName.Left(NclIndex);
-		FinalStaticMaterialSlot.ImportedMaterialSlotName = FName(*TrimmedMaterialRef);
-		UE_LOG(LogTemp, Warning, TEXT("Detected renamed material: %s → %s"), *MaterialName, *TrimmedMaterialRef);
+		StaleMaterial = Session.Settings.bUseMaterialInstances ? nullptr : Cast<UMaterial>(LoadedObj);
+		StaleInstance = Session.Settings.bUseMaterialInstances ? Cast<UMaterialInstanceConstant>(LoadedObj) : nullptr;
 	}
 
-	FString MatPath = "/Game/" + CFGFolderName + "/Materials/" + TrimmedMaterialRef + "." + TrimmedMaterialRef;
-	UMaterial* NewMaterial;
-	if (UObject* LoadedObj = UEditorAssetLibrary::LoadAsset(MatPath))
+	if (LoadedObj && !StaleMaterial && !StaleInstance)
 	{
-
-		if (!LoadedObj)
-		{
-			UE_LOG(LogTemp, Warning, TEXT("No Object Loaded: %s"), *LoadedObj->GetName());
-		}
-		else
-		{
-			UE_LOG(LogTemp, Warning, TEXT("Object Successfully Loaded: %s"), *LoadedObj->GetName());
-		}
-		NewMaterial = Cast<UMaterial>(LoadedObj);
+		UE_LOG(LogTemp, Warning, TEXT("Object Successfully Loaded: %s"), *LoadedObj->GetName());
+		NewMaterial = Cast<UMaterialInterface>(LoadedObj);
 		if (!NewMaterial)
 		{
-			UE_LOG(LogTemp, Warning, TEXT("No Material Loaded: %s"), *NewMaterial->GetName());
+			UE_LOG(LogTemp, Warning, TEXT("No Material Loaded: %s"), *MatPath);
 		}
 		else
 		{
 			UE_LOG(LogTemp, Warning, TEXT("Material Successfully Loaded: %s"), *NewMaterial->GetName());
 		}
+	}
+	else if (Session.Settings.bUseMaterialInstances)
+	{
+		NewMaterial = FDestinyMapImportCFGModule::FCreateMaterialInstance(Session, Context, MaterialName, TexturesJson, TextureFactory, StaleInstance);
 		if (NewMaterial)
 		{
+			Manifest.Record(MaterialJsonPath, MaterialPackagePath);
+			FDestinyMapImportCFGModule::FNoteImportedAsset(Session, MaterialPackagePath);
 		}
 	}
 	else
 	{
-
-		MatPath = "/Game/" + CFGFolderName + "/Materials/" + TrimmedMaterialRef;
-		UPackage* Package = CreatePackage(*MatPath);
-		NewMaterial = NewObject<UMaterial>(Package, *MaterialName, RF_Public | RF_Standalone);
-		NewMaterial->AddToRoot();
+		UMaterial* GeneratedMaterial = StaleMaterial;
+		if (GeneratedMaterial)
+		{
+			GeneratedMaterial->GetEditorOnlyData()->ExpressionCollection.Expressions.Empty();
+			GeneratedMaterial->GetEditorOnlyData()->BaseColor.Expression = nullptr;
+		}
+		else
+		{
+			UPackage* Package = CreatePackage(*MaterialPackagePath);
+			GeneratedMaterial = NewObject<UMaterial>(Package, *MaterialName, RF_Public | RF_Standalone);
+			GeneratedMaterial->AddToRoot();
+		}
 
 		UMaterialExpressionTextureSample* FirstSRGBSample = nullptr;
-		if (bImportTextures == true)
+		if (Session.Settings.bImportTextures == true)
 		{
-			if (bMaterialGen)
+			if (Session.Settings.bMaterialGen)
 			{
-				FDestinyMapImportCFGModule::FImportTextures(MaterialJson, ConfigPath, TextureFactory);
+				FDestinyMapImportCFGModule::FImportTextures(Session, Context, TexturesJson, TextureFactory);
 
-				TMap<FString, TSharedPtr<FJsonValue>> TextureMap = MaterialJson->GetObjectField("Material")->GetObjectField("Pixel")->GetObjectField("Textures")->Values;
+				const TMap<FString, TSharedPtr<FJsonValue>>& TextureMap = TexturesJson->Values;
 
 
 				int32 Index = 0;
@@ -1397,13 +1765,13 @@ void FDestinyMapImportCFGModule::FImportMaterials(FString ConfigPath, FStaticMat
 					TSharedPtr<FJsonObject> TextureObj = TextureEntry.Value->AsObject();
 					FString Hash = TextureObj->GetStringField("Hash");
 					FString Colorspace = TextureObj->GetStringField("Colorspace");
-					FString TexturePath = "/Game/" + CFGFolderName + "/Textures/" + Hash + "." + Hash;
+					FString TexturePath = Session.Settings.GetTexturesPath(Context.FolderName) + "/" + Hash + "." + Hash;
 					UTexture2D* TextureAsset = Cast<UTexture2D>(StaticLoadObject(UTexture2D::StaticClass(), nullptr, *TexturePath));
 					if (!TextureAsset) continue;
 
-					UMaterialExpressionTextureSample* TextureSample = NewObject<UMaterialExpressionTextureSample>(NewMaterial);
+					UMaterialExpressionTextureSample* TextureSample = NewObject<UMaterialExpressionTextureSample>(GeneratedMaterial);
 					TextureSample->Texture = TextureAsset;
-					TextureSample->Material = NewMaterial;
+					TextureSample->Material = GeneratedMaterial;
 					TextureSample->SamplerType = (Colorspace == TEXT("sRGB")) ? SAMPLERTYPE_Color : SAMPLERTYPE_LinearColor;
 					TextureSample->Desc = Hash;
 
@@ -1411,9 +1779,9 @@ void FDestinyMapImportCFGModule::FImportMaterials(FString ConfigPath, FStaticMat
 					TextureSample->MaterialExpressionEditorX = -320;
 					TextureSample->MaterialExpressionEditorY = Index * 300;
 
-					NewMaterial->GetEditorOnlyData()->ExpressionCollection.Expressions.Add(TextureSample);
+					GeneratedMaterial->GetEditorOnlyData()->ExpressionCollection.Expressions.Add(TextureSample);
 
-					if (bDiffuseApply && !FirstSRGBSample && Colorspace == TEXT("sRGB"))
+					if (Session.Settings.bDiffuseApply && !FirstSRGBSample && Colorspace == TEXT("sRGB"))
 					{
 						FirstSRGBSample = TextureSample;
 					}
@@ -1423,26 +1791,189 @@ void FDestinyMapImportCFGModule::FImportMaterials(FString ConfigPath, FStaticMat
 
 
 
-				if (bDiffuseApply && FirstSRGBSample)
+				if (Session.Settings.bDiffuseApply && FirstSRGBSample)
 				{
-					NewMaterial->GetEditorOnlyData()->BaseColor.Expression = FirstSRGBSample;
+					GeneratedMaterial->GetEditorOnlyData()->BaseColor.Expression = FirstSRGBSample;
 				}
 			}
 		}
 
-		NewMaterial->PostEditChange();
-		NewMaterial->MarkPackageDirty();
-		FAssetRegistryModule::AssetCreated(NewMaterial);
+		FDestinyMapImportCFGModule::FQueueMaterialCompile(Session, GeneratedMaterial);
+		GeneratedMaterial->MarkPackageDirty();
+		if (!StaleMaterial) FAssetRegistryModule::AssetCreated(GeneratedMaterial);
+		NewMaterial = GeneratedMaterial;
+		Manifest.Record(MaterialJsonPath, MaterialPackagePath);
+		FDestinyMapImportCFGModule::FNoteImportedAsset(Session, MaterialPackagePath);
+
+	}
+	if (NewMaterial)
+	{
+		Session.MaterialCache.Add(MatPath, NewMaterial);
+	}
+	return NewMaterial;
+}
+
+// Texture parameters of the generated master materials are named Texture0..TextureN in material JSON order
+static FName GetMasterTextureParameterName(int32 Index)
+{
+	return FName(*FString::Printf(TEXT("Texture%d"), Index));
+}
 
+static FString GetSamplerTypeCode(EMaterialSamplerType SamplerType)
+{
+	switch (SamplerType)
+	{
+	case SAMPLERTYPE_Color: return TEXT("C");
+	case SAMPLERTYPE_LinearColor: return TEXT("L");
+	case SAMPLERTYPE_Normal: return TEXT("N");
+	case SAMPLERTYPE_Grayscale: return TEXT("G");
+	case SAMPLERTYPE_LinearGrayscale: return TEXT("H");
+	case SAMPLERTYPE_Alpha: return TEXT("A");
+	case SAMPLERTYPE_Masks: return TEXT("M");
+	default: return FString::FromInt((int32)SamplerType);
 	}
-	if (isStaticMesh == true)
+}
+
+UMaterial* FDestinyMapImportCFGModule::FGetMasterMaterial(FCharmImportSession& Session, const TArray<UTexture2D*>& Textures)
+{
+	// Masters are keyed by the sampler type of every texture slot, so any material with the same layout can share one
+	FString Layout;
+	for (UTexture2D* Texture : Textures)
 	{
-		FinalStaticMaterialSlot.MaterialInterface = NewMaterial;
+		Layout += GetSamplerTypeCode(UMaterialExpressionTextureBase::GetSamplerTypeForTexture(Texture));
+	}
+	const bool bWireBaseColor = Session.Settings.bDiffuseApply && Layout.Contains(TEXT("C"));
+	FString MasterName = TEXT("M_Charm_") + (Layout.IsEmpty() ? FString(TEXT("None")) : Layout) + (bWireBaseColor ? TEXT("") : TEXT("_NoBaseColor"));
+	FString MasterPath = TEXT("/Game/DestinyMapImportCFG/Masters/") + MasterName;
+
+	if (const TWeakObjectPtr<UMaterial>* CachedMaster = Session.MasterMaterialCache.Find(MasterPath))
+	{
+		if (CachedMaster->IsValid()) return CachedMaster->Get();
+	}
+
+	UMaterial* MasterMaterial = Cast<UMaterial>(UEditorAssetLibrary::LoadAsset(MasterPath + TEXT(".") + MasterName));
+	if (!MasterMaterial)
+	{
+		UPackage* Package = CreatePackage(*MasterPath);
+		MasterMaterial = NewObject<UMaterial>(Package, *MasterName, RF_Public | RF_Standalone);
+
+		// The first material of a layout provides the default textures, which also fixes each slot's sampler type
+		bool bBaseColorWired = false;
+		for (int32 Index = 0; Index < Textures.Num(); ++Index)
+		{
+			UMaterialExpressionTextureSampleParameter2D* TextureParameter = NewObject<UMaterialExpressionTextureSampleParameter2D>(MasterMaterial);
+			TextureParameter->ParameterName = GetMasterTextureParameterName(Index);
+			TextureParameter->Texture = Textures[Index];
+			TextureParameter->Material = MasterMaterial;
+			TextureParameter->SamplerType = UMaterialExpressionTextureBase::GetSamplerTypeForTexture(Textures[Index]);
+			TextureParameter->MaterialExpressionEditorX = -320;
+			TextureParameter->MaterialExpressionEditorY = Index * 300;
+			MasterMaterial->GetEditorOnlyData()->ExpressionCollection.Expressions.Add(TextureParameter);
+
+			if (bWireBaseColor && !bBaseColorWired && TextureParameter->SamplerType == SAMPLERTYPE_Color)
+			{
+				MasterMaterial->GetEditorOnlyData()->BaseColor.Expression = TextureParameter;
+				bBaseColorWired = true;
+			}
+		}
+
+		FDestinyMapImportCFGModule::FQueueMaterialCompile(Session, MasterMaterial);
+		MasterMaterial->MarkPackageDirty();
+		FAssetRegistryModule::AssetCreated(MasterMaterial);
+		UE_LOG(LogTemp, Log, TEXT("Created master material %s"), *MasterPath);
+	}
+
+	Session.MasterMaterialCache.Add(MasterPath, MasterMaterial);
+	return MasterMaterial;
+}
+
+UMaterialInterface* FDestinyMapImportCFGModule::FCreateMaterialInstance(FCharmImportSession& Session, const FCharmCFGContext& Context, FString MaterialRef, TSharedPtr<FJsonObject> TexturesJson, UTextureFactory* TextureFactory, UMaterialInstanceConstant* ExistingInstance)
+{
+	TArray<UTexture2D*> Textures;
+	if (Session.Settings.bImportTextures == true && Session.Settings.bMaterialGen)
+	{
+		FDestinyMapImportCFGModule::FImportTextures(Session, Context, TexturesJson, TextureFactory);
+
+		for (const auto& TextureEntry : TexturesJson->Values)
+		{
+			TSharedPtr<FJsonObject> TextureObj = TextureEntry.Value->AsObject();
+			if (!TextureObj.IsValid()) continue;
+			FString Hash = TextureObj->GetStringField("Hash");
+			FString TexturePath = Session.Settings.GetTexturesPath(Context.FolderName) + "/" + Hash + "." + Hash;
+			if (UTexture2D* TextureAsset = Cast<UTexture2D>(StaticLoadObject(UTexture2D::StaticClass(), nullptr, *TexturePath)))
+			{
+				Textures.Add(TextureAsset);
+			}
+		}
+	}
+
+	UMaterial* MasterMaterial = FDestinyMapImportCFGModule::FGetMasterMaterial(Session, Textures);
+	if (!MasterMaterial) return nullptr;
+
+	UMaterialInstanceConstant* MaterialInstance = ExistingInstance;
+	if (MaterialInstance)
+	{
+		MaterialInstance->ClearParameterValuesEditorOnly();
 	}
 	else
 	{
-		FinalSkeletalMaterialSlot.MaterialInterface = NewMaterial;
+		FString PackagePath = Session.Settings.GetMaterialsPath(Context.FolderName) + "/" + MaterialRef;
+		UPackage* Package = CreatePackage(*PackagePath);
+		MaterialInstance = NewObject<UMaterialInstanceConstant>(Package, *MaterialRef, RF_Public | RF_Standalone);
+	}
+	MaterialInstance->SetParentEditorOnly(MasterMaterial);
+	for (int32 Index = 0; Index < Textures.Num(); ++Index)
+	{
+		MaterialInstance->SetTextureParameterValueEditorOnly(FMaterialParameterInfo(GetMasterTextureParameterName(Index)), Textures[Index]);
 	}
+
+	FDestinyMapImportCFGModule::FQueueMaterialCompile(Session, MaterialInstance);
+	MaterialInstance->MarkPackageDirty();
+	if (!ExistingInstance) FAssetRegistryModule::AssetCreated(MaterialInstance);
+	return MaterialInstance;
+}
+
+void FDestinyMapImportCFGModule::FQueueMaterialCompile(FCharmImportSession& Session, UMaterialInterface* Material)
+{
+	if (!Session.bDeferMaterialCompiles)
+	{
+		Material->PostEditChange();
+		return;
+	}
+	Session.DeferredMaterialCompiles.Add(Material);
+}
+
+void FDestinyMapImportCFGModule::FFlushMaterialCompiles(FCharmImportSession& Session)
+{
+	Session.bDeferMaterialCompiles = false;
+	if (Session.DeferredMaterialCompiles.Num() == 0) return;
+
+	// Every material of the stage is recompiled inside one update context instead of a PostEditChange each, which would
+	// open a context per material; primitives using them are re-registered once when the context goes out of scope
+	int32 MaterialCount = 0;
+	{
+		FMaterialUpdateContext UpdateContext;
+		for (const TWeakObjectPtr<UMaterialInterface>& Material : Session.DeferredMaterialCompiles)
+		{
+			if (UMaterial* BaseMaterial = Cast<UMaterial>(Material.Get()))
+			{
+				BaseMaterial->ForceRecompileForRendering();
+			}
+			else if (UMaterialInstance* MaterialInstance = Cast<UMaterialInstance>(Material.Get()))
+			{
+				MaterialInstance->ForceRecompileForRendering();
+			}
+			else
+			{
+				continue;
+			}
+			UpdateContext.AddMaterialInterface(Material.Get());
+			++MaterialCount;
+		}
+	}
+	Session.DeferredMaterialCompiles.Reset();
+
+	UE_LOG(LogTemp, Log, TEXT("Submitted %d materials for shader compilation"), MaterialCount);
 }
 	
 
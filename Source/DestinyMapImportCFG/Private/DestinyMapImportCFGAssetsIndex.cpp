@@ -0,0 +1,135 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "DestinyMapImportCFGAssetsIndex.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+	// Bit per texture source extension, in TextureExtensions order
+	const TCHAR* TextureExtensions[] = { TEXT("tga"), TEXT("png"), TEXT("tiff"), TEXT("tif") };
+	const uint8 TGABit = 1 << 0;
+	const uint8 PNGBit = 1 << 1;
+	const uint8 TIFFBit = 1 << 2;
+	const uint8 TIFBit = 1 << 3;
+
+	/** Calls Visitor with the clean name of every file directly inside Directory */
+	void ForEachFile(const FString& Directory, TFunctionRef<void(const FString&)> Visitor)
+	{
+		IFileManager::Get().IterateDirectory(*Directory, [&Visitor](const TCHAR* Path, bool bIsDirectory)
+		{
+			if (!bIsDirectory) Visitor(FPaths::GetCleanFilename(Path));
+			return true;
+		});
+	}
+}
+
+void FCharmAssetsIndex::Build(const FString& InAssetsPath)
+{
+	AssetsPath = InAssetsPath;
+	TextureFormats.Reset();
+	ModelFiles.Reset();
+	ChunkCounts.Reset();
+	MaterialRefs.Reset();
+
+	ForEachFile(FPaths::Combine(AssetsPath, TEXT("Textures")), [this](const FString& FileName)
+	{
+		const FString Extension = FPaths::GetExtension(FileName);
+		for (int32 Index = 0; Index < UE_ARRAY_COUNT(TextureExtensions); ++Index)
+		{
+			if (Extension == TextureExtensions[Index])
+			{
+				TextureFormats.FindOrAdd(FPaths::GetBaseFilename(FileName)) |= (1 << Index);
+				break;
+			}
+		}
+	});
+
+	ForEachFile(FPaths::Combine(AssetsPath, TEXT("Materials")), [this](const FString& FileName)
+	{
+		if (FPaths::GetExtension(FileName) == TEXT("json")) MaterialRefs.Add(FPaths::GetBaseFilename(FileName));
+	});
+
+	// Models/<Type>/<Name>.fbx, terrain chunks are <Name>_<N>.fbx
+	TArray<FString> Types;
+	IFileManager::Get().FindFiles(Types, *FPaths::Combine(AssetsPath, TEXT("Models"), TEXT("*")), false, true);
+	for (const FString& Type : Types)
+	{
+		TSet<FString>& Models = ModelFiles.Add(Type);
+		TMap<FString, TSet<int32>> ChunkIndices;
+		ForEachFile(FPaths::Combine(AssetsPath, TEXT("Models"), Type), [&Models, &ChunkIndices](const FString& FileName)
+		{
+			if (FPaths::GetExtension(FileName) != TEXT("fbx")) return;
+			FString ModelName = FPaths::GetBaseFilename(FileName);
+			Models.Add(ModelName);
+
+			FString Prefix, Suffix;
+			if (ModelName.Split(TEXT("_"), &Prefix, &Suffix, ESearchCase::CaseSensitive, ESearchDir::FromEnd) && Suffix.Len() > 0 && Suffix.IsNumeric())
+			{
+				ChunkIndices.FindOrAdd(Prefix).Add(FCString::Atoi(*Suffix));
+			}
+		});
+
+		for (const TPair<FString, TSet<int32>>& Chunks : ChunkIndices)
+		{
+			int32 ChunkCount = 0;
+			while (Chunks.Value.Contains(ChunkCount)) ++ChunkCount;
+			if (ChunkCount > 0) ChunkCounts.Add(Type / Chunks.Key, ChunkCount);
+		}
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("Indexed %s: %d textures, %d materials, %d model folders"), *AssetsPath, TextureFormats.Num(), MaterialRefs.Num(), ModelFiles.Num());
+}
+
+FString FCharmAssetsIndex::FindTextureSource(const FString& Hash, ETextureFormat SelectedFormat) const
+{
+	const uint8* Available = TextureFormats.Find(Hash);
+	if (!Available) return FString();
+
+	TArray<uint8, TInlineAllocator<4>> Preferred;
+	switch (SelectedFormat)
+	{
+	case ETextureFormat::TF_PNG:
+		Preferred = { PNGBit };
+		break;
+
+	case ETextureFormat::TF_TGA:
+		Preferred = { TGABit };
+		break;
+
+	case ETextureFormat::TF_TIF:
+		Preferred = { TIFFBit, TIFBit };
+		break;
+
+	case ETextureFormat::TF_Auto:
+	default:
+		Preferred = { TGABit, PNGBit, TIFFBit, TIFBit };
+		break;
+	}
+
+	for (uint8 Bit : Preferred)
+	{
+		if (*Available & Bit)
+		{
+			return FPaths::Combine(AssetsPath, TEXT("Textures"), Hash + TEXT(".") + TextureExtensions[FMath::FloorLog2(Bit)]);
+		}
+	}
+	return FString();
+}
+
+bool FCharmAssetsIndex::HasModel(const FString& Type, const FString& ModelName) const
+{
+	const TSet<FString>* Models = ModelFiles.Find(Type);
+	return Models && Models->Contains(ModelName);
+}
+
+int32 FCharmAssetsIndex::GetChunkCount(const FString& Type, const FString& ModelName) const
+{
+	const int32* ChunkCount = ChunkCounts.Find(Type / ModelName);
+	return ChunkCount ? *ChunkCount : 0;
+}
+
+bool FCharmAssetsIndex::HasMaterial(const FString& MaterialRef) const
+{
+	return MaterialRefs.Contains(MaterialRef);
+}
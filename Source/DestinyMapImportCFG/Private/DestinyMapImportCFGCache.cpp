@@ -0,0 +1,361 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "DestinyMapImportCFGCache.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/SecureHash.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Templates/UniquePtr.h"
+
+namespace
+{
+	const uint32 CFGCacheMagic = 0x47464343;    // "CCFG"
+	const uint32 LightsCacheMagic = 0x4C464343; // "CCFL"
+	const uint32 CacheVersion = 1;
+
+	enum class ECharmCacheRecord : uint8
+	{
+		End,
+		Part,
+		Instances,
+	};
+
+	struct FCacheStamp
+	{
+		uint32 Magic = 0;
+		uint32 Version = 0;
+		int64 SourceSize = -1;
+		int64 SourceTicks = 0;
+		FMD5Hash SourceHash;
+
+		friend FArchive& operator<<(FArchive& Ar, FCacheStamp& Stamp)
+		{
+			return Ar << Stamp.Magic << Stamp.Version << Stamp.SourceSize << Stamp.SourceTicks << Stamp.SourceHash;
+		}
+	};
+
+	bool MakeSourceStamp(const FString& SourcePath, uint32 Magic, FCacheStamp& OutStamp)
+	{
+		OutStamp.Magic = Magic;
+		OutStamp.Version = CacheVersion;
+		OutStamp.SourceSize = IFileManager::Get().FileSize(*SourcePath);
+		OutStamp.SourceTicks = IFileManager::Get().GetTimeStamp(*SourcePath).GetTicks();
+		return OutStamp.SourceSize >= 0;
+	}
+
+	void SerializeInstances(FArchive& Ar, FCharmInstanceBuffer& Instances)
+	{
+		for (TArray<float>* Component : { &Instances.TX, &Instances.TY, &Instances.TZ, &Instances.QX, &Instances.QY, &Instances.QZ, &Instances.QW, &Instances.SX, &Instances.SY, &Instances.SZ })
+		{
+			Component->BulkSerialize(Ar);
+		}
+	}
+
+	/**
+	 * Reads the header and every record of a CFG sidecar. Without Callbacks it only checks that the stream is
+	 * complete, down to its End record, so a damaged sidecar is caught before any consumer saw part of it.
+	 */
+	bool ReplayCFGRecords(FArchive& Ar, const FCharmCFGCallbacks* Callbacks)
+	{
+		FCharmCFGHeader Header;
+		Ar << Header.ExportType << Header.Type << Header.MeshName << Header.AssetsPath;
+		if (Ar.IsError()) return false;
+		if (Callbacks && Callbacks->OnHeader && !Callbacks->OnHeader(Header)) return true;
+
+		// Records are replayed one at a time, only a single Instances entry is decoded at once
+		while (!Ar.IsError() && !Ar.AtEnd())
+		{
+			uint8 Record = 0;
+			Ar << Record;
+			if ((ECharmCacheRecord)Record == ECharmCacheRecord::Part)
+			{
+				FString ModelName;
+				TArray<FString> MaterialRefs;
+				Ar << ModelName << MaterialRefs;
+				if (!Ar.IsError() && Callbacks && Callbacks->OnPart) Callbacks->OnPart(ModelName, MaterialRefs);
+			}
+			else if ((ECharmCacheRecord)Record == ECharmCacheRecord::Instances)
+			{
+				FString MeshName;
+				FCharmInstanceBuffer Instances;
+				Ar << MeshName;
+				SerializeInstances(Ar, Instances);
+				if (!Ar.IsError() && Callbacks && Callbacks->OnInstances) Callbacks->OnInstances(MeshName, Instances);
+			}
+			else
+			{
+				return !Ar.IsError() && (ECharmCacheRecord)Record == ECharmCacheRecord::End;
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * Memory maps a sidecar and validates it against its source. Same size and timestamp are enough to trust it;
+	 * if only the timestamp moved the source MD5 decides, and a match writes the new timestamp back once unmapped.
+	 */
+	class FMappedCache
+	{
+	public:
+		~FMappedCache()
+		{
+			Archive.Reset();
+			MappedRegion.Reset();
+			MappedFile.Reset();
+			if (bRefreshStamp) RefreshStamp();
+			if (bDamaged) IFileManager::Get().Delete(*CachePath, false, false, true);
+		}
+
+		bool Open(const FString& SourcePath, uint32 Magic)
+		{
+			CachePath = FCharmCFGCache::GetCachePath(SourcePath);
+			if (!FPaths::FileExists(CachePath)) return false;
+
+			FCacheStamp SourceStamp;
+			if (!MakeSourceStamp(SourcePath, Magic, SourceStamp)) return false;
+
+			MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*CachePath));
+			if (!MappedFile) return false;
+			MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize(), true));
+			if (!MappedRegion) return false;
+			Archive = MakeUnique<FMemoryReaderView>(FMemoryView(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize()));
+
+			FCacheStamp CacheStamp;
+			*Archive << CacheStamp;
+			if (Archive->IsError()
+				|| CacheStamp.Magic != SourceStamp.Magic
+				|| CacheStamp.Version != SourceStamp.Version
+				|| CacheStamp.SourceSize != SourceStamp.SourceSize)
+			{
+				return false;
+			}
+			if (CacheStamp.SourceTicks == SourceStamp.SourceTicks) return true;
+
+			// Same size, new timestamp: a re-export often rewrites identical files, only the content decides
+			if (!CacheStamp.SourceHash.IsValid() || FMD5Hash::HashFile(*SourcePath) != CacheStamp.SourceHash) return false;
+			CacheStamp.SourceTicks = SourceStamp.SourceTicks;
+			RefreshedStamp = CacheStamp;
+			bRefreshStamp = true;
+			return true;
+		}
+
+		FArchive& GetArchive() { return *Archive; }
+
+		/** The sidecar failed to replay: it is not refreshed and gets deleted once unmapped */
+		void MarkDamaged() { bRefreshStamp = false; bDamaged = true; }
+
+	private:
+		// The stamp keeps its size when only the ticks change, so it is patched over the old one and the
+		// sidecar replaced through a temp file like a fresh write; an append handle can't write at offset 0
+		void RefreshStamp()
+		{
+			TArray<uint8> StampBytes;
+			FMemoryWriter StampWriter(StampBytes);
+			StampWriter << RefreshedStamp;
+
+			TArray64<uint8> CacheBytes;
+			const FString TempPath = CachePath + TEXT(".tmp");
+			if (!FFileHelper::LoadFileToArray(CacheBytes, *CachePath) || CacheBytes.Num() < StampBytes.Num())
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Failed to refresh CFG cache %s"), *CachePath);
+				return;
+			}
+			FMemory::Memcpy(CacheBytes.GetData(), StampBytes.GetData(), StampBytes.Num());
+			if (!FFileHelper::SaveArrayToFile(CacheBytes, *TempPath) || !IFileManager::Get().Move(*CachePath, *TempPath, true))
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Failed to refresh CFG cache %s"), *CachePath);
+				IFileManager::Get().Delete(*TempPath);
+			}
+		}
+
+		// Destroyed in reverse order, so the region goes before its file handle
+		TUniquePtr<IMappedFileHandle> MappedFile;
+		TUniquePtr<IMappedFileRegion> MappedRegion;
+		TUniquePtr<FMemoryReaderView> Archive;
+		FCacheStamp RefreshedStamp;
+		FString CachePath;
+		bool bRefreshStamp = false;
+		bool bDamaged = false;
+	};
+
+	/** Writes to a temp file and only replaces the sidecar once everything was written */
+	class FCacheWriter
+	{
+	public:
+		bool Open(const FString& SourcePath, uint32 Magic)
+		{
+			CachePath = FCharmCFGCache::GetCachePath(SourcePath);
+			TempPath = CachePath + TEXT(".tmp");
+
+			FCacheStamp Stamp;
+			if (!MakeSourceStamp(SourcePath, Magic, Stamp)) return false;
+			Stamp.SourceHash = FMD5Hash::HashFile(*SourcePath);
+
+			Archive.Reset(IFileManager::Get().CreateFileWriter(*TempPath));
+			if (!Archive) return false;
+			*Archive << Stamp;
+			return true;
+		}
+
+		FArchive* GetArchive() { return Archive.Get(); }
+
+		void Commit()
+		{
+			if (!Archive) return;
+			const bool bWritten = Archive->Close();
+			Archive.Reset();
+			if (!bWritten || !IFileManager::Get().Move(*CachePath, *TempPath, true))
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Failed to write CFG cache %s"), *CachePath);
+				IFileManager::Get().Delete(*TempPath);
+			}
+		}
+
+		void Discard()
+		{
+			if (!Archive) return;
+			Archive->Close();
+			Archive.Reset();
+			IFileManager::Get().Delete(*TempPath);
+		}
+
+	private:
+		FString CachePath;
+		FString TempPath;
+		TUniquePtr<FArchive> Archive;
+	};
+}
+
+FString FCharmCFGCache::GetCachePath(const FString& SourcePath)
+{
+	return SourcePath + TEXT(".cfgcache");
+}
+
+bool FCharmCFGCache::Read(const FString& ConfigPath, const FCharmCFGCallbacks& Callbacks)
+{
+	{
+		FMappedCache Cache;
+		if (Cache.Open(ConfigPath, CFGCacheMagic))
+		{
+			// The mapped records are checked in full first, replaying them a second time is cheap next to the JSON
+			FArchive& Ar = Cache.GetArchive();
+			const int64 RecordsStart = Ar.Tell();
+			if (ReplayCFGRecords(Ar, nullptr))
+			{
+				Ar.Seek(RecordsStart);
+				return ReplayCFGRecords(Ar, &Callbacks);
+			}
+			UE_LOG(LogTemp, Warning, TEXT("CFG cache %s is damaged, reading %s instead"), *GetCachePath(ConfigPath), *ConfigPath);
+			Cache.MarkDamaged();
+		}
+	}
+
+	// No usable sidecar: stream the JSON and record every callback into a new one on the way through
+	FCacheWriter Writer;
+	const bool bWriting = Writer.Open(ConfigPath, CFGCacheMagic);
+
+	bool bAccepted = true;
+	bool bHeaderChecked = false;
+	FCharmCFGCallbacks ForwardingCallbacks;
+	ForwardingCallbacks.OnHeader = [&Callbacks, &Writer, &bAccepted, &bHeaderChecked](const FCharmCFGHeader& InHeader)
+	{
+		if (FArchive* Ar = Writer.GetArchive())
+		{
+			FCharmCFGHeader Header = InHeader;
+			*Ar << Header.ExportType << Header.Type << Header.MeshName << Header.AssetsPath;
+		}
+		bHeaderChecked = true;
+		bAccepted = !Callbacks.OnHeader || Callbacks.OnHeader(InHeader);
+		// Keep reading a rejected file only when the sidecar still needs the rest of it
+		return bAccepted || Writer.GetArchive() != nullptr;
+	};
+	ForwardingCallbacks.OnPart = [&Callbacks, &Writer, &bAccepted](const FString& ModelName, const TArray<FString>& MaterialRefs)
+	{
+		if (FArchive* Ar = Writer.GetArchive())
+		{
+			uint8 Record = (uint8)ECharmCacheRecord::Part;
+			FString Name = ModelName;
+			TArray<FString> Refs = MaterialRefs;
+			*Ar << Record << Name << Refs;
+		}
+		if (bAccepted && Callbacks.OnPart) Callbacks.OnPart(ModelName, MaterialRefs);
+	};
+	// Left unset when neither the sidecar nor the caller wants the placements, so the reader skips them undecoded
+	if (bWriting || Callbacks.OnInstances)
+	{
+		ForwardingCallbacks.OnInstances = [&Callbacks, &Writer, &bAccepted](const FString& MeshName, FCharmInstanceBuffer& Instances)
+		{
+			// Recorded before forwarding, consumers convert the buffer in place
+			if (FArchive* Ar = Writer.GetArchive())
+			{
+				uint8 Record = (uint8)ECharmCacheRecord::Instances;
+				FString Name = MeshName;
+				*Ar << Record << Name;
+				SerializeInstances(*Ar, Instances);
+			}
+			if (bAccepted && Callbacks.OnInstances) Callbacks.OnInstances(MeshName, Instances);
+		};
+	}
+
+	const bool bRead = FCharmCFGReader::Read(ConfigPath, ForwardingCallbacks);
+	if (bWriting && bRead && bHeaderChecked)
+	{
+		uint8 Record = (uint8)ECharmCacheRecord::End;
+		*Writer.GetArchive() << Record;
+		Writer.Commit();
+	}
+	else
+	{
+		Writer.Discard();
+	}
+	return bRead;
+}
+
+bool FCharmCFGCache::ReadLights(const FString& LightsPath, TArray<FCharmLight>& OutLights)
+{
+	const int32 FirstLight = OutLights.Num();
+	{
+		FMappedCache Cache;
+		if (Cache.Open(LightsPath, LightsCacheMagic))
+		{
+			FArchive& Ar = Cache.GetArchive();
+
+			int32 NumLights = 0;
+			Ar << NumLights;
+			for (int32 LightIndex = 0; LightIndex < NumLights && !Ar.IsError(); ++LightIndex)
+			{
+				FCharmLight& Light = OutLights.AddDefaulted_GetRef();
+				Ar << Light.Name << Light.Type << Light.Color << Light.Attenuation << Light.Cookie;
+				SerializeInstances(Ar, Light.Instances);
+			}
+			if (!Ar.IsError()) return true;
+
+			// Nothing read from a damaged sidecar is kept, the JSON is read instead
+			UE_LOG(LogTemp, Warning, TEXT("Lights cache %s is damaged, reading %s instead"), *GetCachePath(LightsPath), *LightsPath);
+			OutLights.SetNum(FirstLight);
+			Cache.MarkDamaged();
+		}
+	}
+
+	if (!FCharmCFGReader::ReadLights(LightsPath, OutLights)) return false;
+
+	FCacheWriter Writer;
+	if (Writer.Open(LightsPath, LightsCacheMagic))
+	{
+		FArchive& Ar = *Writer.GetArchive();
+		int32 NumLights = OutLights.Num() - FirstLight;
+		Ar << NumLights;
+		for (int32 LightIndex = FirstLight; LightIndex < OutLights.Num(); ++LightIndex)
+		{
+			FCharmLight& Light = OutLights[LightIndex];
+			Ar << Light.Name << Light.Type << Light.Color << Light.Attenuation << Light.Cookie;
+			SerializeInstances(Ar, Light.Instances);
+		}
+		Writer.Commit();
+	}
+	return true;
+}
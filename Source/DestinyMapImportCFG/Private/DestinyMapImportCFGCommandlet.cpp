@@ -0,0 +1,183 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "DestinyMapImportCFGCommandlet.h"
+#include "DestinyMapImportCFG.h"
+#include "EditorAssetLibrary.h"
+#include "FileHelpers.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "Modules/ModuleManager.h"
+
+UDestinyMapImportCFGCommandlet::UDestinyMapImportCFGCommandlet()
+{
+	IsClient = false;
+	IsEditor = true;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UDestinyMapImportCFGCommandlet::Main(const FString& Params)
+{
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamVals;
+	ParseCommandLine(*Params, Tokens, Switches, ParamVals);
+
+	const FString* CFGParam = ParamVals.Find(TEXT("cfg"));
+	if (!CFGParam || CFGParam->IsEmpty())
+	{
+		UE_LOG(LogTemp, Error, TEXT("Usage: -run=DestinyMapImportCFG -cfg=<file.cfg>[+<file.cfg>...|<folder>] [-map=/Game/Maps/<Map>] [-scale=100] [-textures=auto|png|tga|tif] [-notextures] [-nomaterials] [-materialinstances] [-dedupematerials] [-nolights] [-nomodels] [-nobuild] [-noinstancing] [-nobulkplacement] [-worldpartition] [-cellsize=25600] [-decoratorcell=6400] [-decoratorcells3d] [-instancethreshold=8] [-nocfgcache] [-textureprefetch=32] [-importbatch=64] [-interchange] [-interchangejobs=8] [-sharedlibrary[=/Game/DestinyShared]]"));
+		return 1;
+	}
+
+	// -cfg accepts a '+' separated list of CFG files or a folder containing them
+	TArray<FString> CFGEntries;
+	CFGParam->ParseIntoArray(CFGEntries, TEXT("+"));
+	TArray<FString> CFGFiles;
+	for (const FString& Entry : CFGEntries)
+	{
+		if (IFileManager::Get().DirectoryExists(*Entry))
+		{
+			TArray<FString> FoundFiles;
+			IFileManager::Get().FindFiles(FoundFiles, *FPaths::Combine(Entry, TEXT("*.cfg")), true, false);
+			FoundFiles.Sort();
+			for (const FString& FoundFile : FoundFiles)
+			{
+				CFGFiles.Add(FPaths::Combine(Entry, FoundFile));
+			}
+		}
+		else if (FPaths::FileExists(Entry))
+		{
+			CFGFiles.Add(Entry);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("CFG path not found: %s"), *Entry);
+		}
+	}
+	if (CFGFiles.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("No CFG files to import"));
+		return 1;
+	}
+
+	FDestinyMapImportCFGModule& ImportModule = FModuleManager::LoadModuleChecked<FDestinyMapImportCFGModule>("DestinyMapImportCFG");
+
+	ImportModule.Settings.bImportTextures = !Switches.Contains(TEXT("notextures"));
+	ImportModule.Settings.bImportMaterials = !Switches.Contains(TEXT("nomaterials"));
+	ImportModule.Settings.bImportLights = !Switches.Contains(TEXT("nolights"));
+	ImportModule.Settings.bUseMaterialInstances = Switches.Contains(TEXT("materialinstances"));
+	ImportModule.Settings.bDedupeMaterials = Switches.Contains(TEXT("dedupematerials"));
+	ImportModule.Settings.bInstanceMeshes = !Switches.Contains(TEXT("noinstancing"));
+	ImportModule.Settings.bBulkPlacement = !Switches.Contains(TEXT("nobulkplacement"));
+	ImportModule.Settings.bWorldPartitionOutput = Switches.Contains(TEXT("worldpartition"));
+	if (const FString* CellSizeParam = ParamVals.Find(TEXT("cellsize")))
+	{
+		ImportModule.Settings.WorldPartitionCellSize = FMath::Max(100.f, FCString::Atof(**CellSizeParam));
+	}
+	if (const FString* DecoratorCellParam = ParamVals.Find(TEXT("decoratorcell")))
+	{
+		ImportModule.Settings.DecoratorCellSize = FMath::Max(0.f, FCString::Atof(**DecoratorCellParam));
+	}
+	ImportModule.Settings.bDecoratorCells3D = Switches.Contains(TEXT("decoratorcells3d"));
+	ImportModule.Settings.bCacheParsedCFG = !Switches.Contains(TEXT("nocfgcache"));
+	if (const FString* ThresholdParam = ParamVals.Find(TEXT("instancethreshold")))
+	{
+		ImportModule.Settings.InstancingThreshold = FMath::Max(1, FCString::Atoi(**ThresholdParam));
+	}
+	if (const FString* PrefetchParam = ParamVals.Find(TEXT("textureprefetch")))
+	{
+		ImportModule.Settings.TexturePrefetchDepth = FMath::Max(1, FCString::Atoi(**PrefetchParam));
+	}
+	ImportModule.Settings.bUseInterchange = Switches.Contains(TEXT("interchange"));
+	if (const FString* JobsParam = ParamVals.Find(TEXT("interchangejobs")))
+	{
+		ImportModule.Settings.InterchangeMaxInFlight = FMath::Max(1, FCString::Atoi(**JobsParam));
+	}
+	if (const FString* BatchParam = ParamVals.Find(TEXT("importbatch")))
+	{
+		ImportModule.Settings.ModelImportBatchSize = FMath::Max(1, FCString::Atoi(**BatchParam));
+	}
+	if (const FString* LibraryParam = ParamVals.Find(TEXT("sharedlibrary")))
+	{
+		ImportModule.Settings.bUseSharedLibrary = true;
+		ImportModule.Settings.SharedLibraryRoot = *LibraryParam;
+	}
+	else
+	{
+		ImportModule.Settings.bUseSharedLibrary = Switches.Contains(TEXT("sharedlibrary"));
+	}
+	if (const FString* ScaleParam = ParamVals.Find(TEXT("scale")))
+	{
+		ImportModule.Settings.fMapScale = FCString::Atof(**ScaleParam);
+	}
+	if (const FString* TexturesParam = ParamVals.Find(TEXT("textures")))
+	{
+		if (*TexturesParam == TEXT("png")) ImportModule.Settings.SelectedFormat = ETextureFormat::TF_PNG;
+		else if (*TexturesParam == TEXT("tga")) ImportModule.Settings.SelectedFormat = ETextureFormat::TF_TGA;
+		else if (*TexturesParam == TEXT("tif") || *TexturesParam == TEXT("tiff")) ImportModule.Settings.SelectedFormat = ETextureFormat::TF_TIF;
+		else ImportModule.Settings.SelectedFormat = ETextureFormat::TF_Auto;
+	}
+
+	if (!Switches.Contains(TEXT("nomodels")))
+	{
+		TSharedRef<FCharmImportSession> Session = ImportModule.FBeginImportSession();
+
+		// One CFG at a time so each folder's assets are written to disk before the next one starts
+		for (const FString& CFGFile : CFGFiles)
+		{
+			UE_LOG(LogTemp, Display, TEXT("Importing models from %s"), *CFGFile);
+			ImportModule.FImportModels(Session, { CFGFile });
+			ImportModule.FWaitForPendingImports(*Session);
+
+			FString FolderPath = TEXT("/Game/") + FCharmCFGContext::GetFolderName(CFGFile);
+			if (UEditorAssetLibrary::DoesDirectoryExist(FolderPath))
+			{
+				UEditorAssetLibrary::SaveDirectory(FolderPath, true, true);
+			}
+			if (ImportModule.Settings.bUseSharedLibrary && UEditorAssetLibrary::DoesDirectoryExist(ImportModule.Settings.SharedLibraryRoot))
+			{
+				UEditorAssetLibrary::SaveDirectory(ImportModule.Settings.SharedLibraryRoot, true, true);
+			}
+		}
+	}
+
+	if (Switches.Contains(TEXT("nobuild")))
+	{
+		return 0;
+	}
+
+	const FString* MapParam = ParamVals.Find(TEXT("map"));
+	if (!MapParam)
+	{
+		UE_LOG(LogTemp, Display, TEXT("No -map given, skipping map build"));
+		return 0;
+	}
+
+	UWorld* World = nullptr;
+	if (UEditorAssetLibrary::DoesAssetExist(*MapParam))
+	{
+		World = UEditorLoadingAndSavingUtils::LoadMap(*MapParam);
+	}
+	else
+	{
+		World = UEditorLoadingAndSavingUtils::NewBlankMap(false);
+	}
+	if (!World)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to open map %s"), **MapParam);
+		return 1;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Building map %s"), **MapParam);
+	ImportModule.FBuildMap(CFGFiles);
+
+	if (!UEditorLoadingAndSavingUtils::SaveMap(World, *MapParam))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Failed to save map %s"), **MapParam);
+		return 1;
+	}
+	UEditorLoadingAndSavingUtils::SaveDirtyPackages(false, true);
+
+	return 0;
+}
@@ -0,0 +1,84 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "DestinyMapImportCFGInstances.h"
+#include "Dom/JsonObject.h"
+
+void FCharmInstanceBuffer::Reset(int32 ExpectedNum)
+{
+	for (TArray<float>* Component : { &TX, &TY, &TZ, &QX, &QY, &QZ, &QW, &SX, &SY, &SZ })
+	{
+		Component->Reset(ExpectedNum);
+	}
+}
+
+void FCharmInstanceBuffer::Add(const float Translation[3], const float Rotation[4], const float Scale[3])
+{
+	TX.Add(Translation[0]);
+	TY.Add(Translation[1]);
+	TZ.Add(Translation[2]);
+	QX.Add(Rotation[0]);
+	QY.Add(Rotation[1]);
+	QZ.Add(Rotation[2]);
+	QW.Add(Rotation[3]);
+	SX.Add(Scale[0]);
+	SY.Add(Scale[1]);
+	SZ.Add(Scale[2]);
+}
+
+void FCharmInstanceBuffer::DecodeJson(const TArray<TSharedPtr<FJsonValue>>& InstanceArray)
+{
+	Reset(InstanceArray.Num());
+
+	for (const TSharedPtr<FJsonValue>& InstanceVal : InstanceArray)
+	{
+		const TSharedPtr<FJsonObject>* InstanceObj;
+		if (!InstanceVal.IsValid() || !InstanceVal->TryGetObject(InstanceObj)) continue;
+
+		const TArray<TSharedPtr<FJsonValue>>* TranslationArray;
+		const TArray<TSharedPtr<FJsonValue>>* RotationArray;
+		const TArray<TSharedPtr<FJsonValue>>* ScaleArray;
+		if (!(*InstanceObj)->TryGetArrayField(TEXT("Translation"), TranslationArray) || TranslationArray->Num() < 3 ||
+			!(*InstanceObj)->TryGetArrayField(TEXT("Rotation"), RotationArray) || RotationArray->Num() < 4 ||
+			!(*InstanceObj)->TryGetArrayField(TEXT("Scale"), ScaleArray) || ScaleArray->Num() < 3)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Skipping instance with missing Translation/Rotation/Scale"));
+			continue;
+		}
+
+		const float Translation[3] = { (float)(*TranslationArray)[0]->AsNumber(), (float)(*TranslationArray)[1]->AsNumber(), (float)(*TranslationArray)[2]->AsNumber() };
+		const float Rotation[4] = { (float)(*RotationArray)[0]->AsNumber(), (float)(*RotationArray)[1]->AsNumber(), (float)(*RotationArray)[2]->AsNumber(), (float)(*RotationArray)[3]->AsNumber() };
+		const float Scale[3] = { (float)(*ScaleArray)[0]->AsNumber(), (float)(*ScaleArray)[1]->AsNumber(), (float)(*ScaleArray)[2]->AsNumber() };
+		Add(Translation, Rotation, Scale);
+	}
+}
+
+void FCharmInstanceBuffer::ConvertCharmToUnreal(float MapScale)
+{
+	const int32 Count = Num();
+	const float FlippedMapScale = -MapScale;
+
+	// One independent loop per component keeps every pass a straight multiply over contiguous floats
+	float* RESTRICT X = TX.GetData();
+	float* RESTRICT Y = TY.GetData();
+	float* RESTRICT Z = TZ.GetData();
+	float* RESTRICT RotY = QY.GetData();
+	float* RESTRICT RotW = QW.GetData();
+	for (int32 Index = 0; Index < Count; ++Index) X[Index] *= MapScale;
+	for (int32 Index = 0; Index < Count; ++Index) Y[Index] *= FlippedMapScale;
+	for (int32 Index = 0; Index < Count; ++Index) Z[Index] *= MapScale;
+	for (int32 Index = 0; Index < Count; ++Index) RotY[Index] = -RotY[Index];
+	for (int32 Index = 0; Index < Count; ++Index) RotW[Index] = -RotW[Index];
+}
+
+void FCharmInstanceBuffer::ToTransforms(TArray<FTransform>& OutTransforms) const
+{
+	const int32 Count = Num();
+	OutTransforms.SetNumUninitialized(Count);
+	for (int32 Index = 0; Index < Count; ++Index)
+	{
+		OutTransforms[Index] = FTransform(
+			FQuat(QX[Index], QY[Index], QZ[Index], QW[Index]),
+			FVector(TX[Index], TY[Index], TZ[Index]),
+			FVector(SX[Index], SY[Index], SZ[Index]));
+	}
+}
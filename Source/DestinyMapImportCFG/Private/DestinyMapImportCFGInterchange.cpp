@@ -0,0 +1,138 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "DestinyMapImportCFGInterchange.h"
+#include "InterchangeManager.h"
+#include "InterchangeSourceData.h"
+#include "InterchangeGenericAssetsPipeline.h"
+#include "InterchangeGenericMeshPipeline.h"
+#include "InterchangeGenericMaterialPipeline.h"
+#include "InterchangeGenericTexturePipeline.h"
+#include "InterchangeGenericAnimationPipeline.h"
+#include "InterchangeGenericAssetsPipelineSharedSettings.h"
+#include "Async/Async.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Containers/Ticker.h"
+#include "UObject/Package.h"
+
+FCharmInterchangeImporter::FCharmInterchangeImporter(float ImportUniformScale, int32 InMaxInFlight)
+	: MaxInFlight(FMath::Max(InMaxInFlight, 1))
+{
+	Pipeline.Reset(NewObject<UInterchangeGenericAssetsPipeline>(GetTransientPackage()));
+	Pipeline->ImportOffsetUniformScale = ImportUniformScale;
+	Pipeline->CommonMeshesProperties->ForceAllMeshAsType = EInterchangeForceMeshType::IFMT_StaticMesh;
+	Pipeline->MeshPipeline->bCombineStaticMeshes = true;
+	Pipeline->MaterialPipeline->bImportMaterials = false;
+	Pipeline->MaterialPipeline->TexturePipeline->bImportTextures = false;
+	Pipeline->AnimationPipeline->bImportAnimations = false;
+}
+
+void FCharmInterchangeImporter::Enqueue(const FString& SourcePath, const FString& DestinationPath, TFunction<void(const TArray<UObject*>&)> OnImported)
+{
+	Pending.Add({ SourcePath, DestinationPath, MoveTemp(OnImported) });
+}
+
+void FCharmInterchangeImporter::Start()
+{
+	UE_LOG(LogTemp, Log, TEXT("Interchange importing %d files, %d at a time"), Pending.Num(), MaxInFlight);
+	if (Pending.Num() == 0)
+	{
+		Finish();
+		return;
+	}
+	while (NumLaunched < Pending.Num() && NumLaunched - NumCompleted < MaxInFlight)
+	{
+		LaunchNext();
+	}
+}
+
+void FCharmInterchangeImporter::LaunchNext()
+{
+	const int32 FileIndex = NumLaunched++;
+	const FPendingFile& File = Pending[FileIndex];
+
+	UInterchangeManager& InterchangeManager = UInterchangeManager::GetInterchangeManager();
+	UInterchangeSourceData* SourceData = UInterchangeManager::CreateSourceData(File.SourcePath);
+
+	FImportAssetParameters ImportAssetParameters;
+	ImportAssetParameters.bIsAutomated = true;
+	ImportAssetParameters.bReplaceExisting = true;
+	ImportAssetParameters.OverridePipelines.Add(FSoftObjectPath(Pipeline.Get()));
+
+	UE::Interchange::FAssetImportResultRef ImportResult = InterchangeManager.ImportAssetAsync(File.DestinationPath, SourceData, ImportAssetParameters);
+
+	TWeakPtr<FCharmInterchangeImporter> WeakThis = AsShared();
+	ImportResult->OnDone([WeakThis, FileIndex](UE::Interchange::FImportResult& Result)
+	{
+		// Weak across the hop, a garbage collection before the task runs must not leave dangling pointers
+		TArray<TWeakObjectPtr<UObject>> WeakImportedObjects;
+		for (UObject* ImportedObject : Result.GetImportedObjects())
+		{
+			WeakImportedObjects.Add(ImportedObject);
+		}
+		// Material binding creates assets, so it always runs on the game thread
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, FileIndex, WeakImportedObjects = MoveTemp(WeakImportedObjects)]()
+		{
+			TSharedPtr<FCharmInterchangeImporter> This = WeakThis.Pin();
+			if (!This.IsValid()) return;
+
+			TArray<UObject*> ImportedObjects;
+			for (const TWeakObjectPtr<UObject>& WeakImportedObject : WeakImportedObjects)
+			{
+				if (UObject* ImportedObject = WeakImportedObject.Get()) ImportedObjects.Add(ImportedObject);
+			}
+			This->OnFileDone(FileIndex, ImportedObjects);
+		});
+	});
+}
+
+void FCharmInterchangeImporter::OnFileDone(int32 FileIndex, const TArray<UObject*>& ImportedObjects)
+{
+	++NumCompleted;
+
+	const FPendingFile& File = Pending[FileIndex];
+	if (ImportedObjects.Num() == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Interchange imported nothing from %s"), *File.SourcePath);
+	}
+	else if (File.OnImported)
+	{
+		File.OnImported(ImportedObjects);
+	}
+
+	if (NumLaunched < Pending.Num())
+	{
+		LaunchNext();
+	}
+	else if (IsDone())
+	{
+		UE_LOG(LogTemp, Log, TEXT("Interchange import finished, %d files"), Pending.Num());
+		Finish();
+	}
+}
+
+void FCharmInterchangeImporter::Finish()
+{
+	// The owner usually releases the importer from OnFinished
+	TSharedRef<FCharmInterchangeImporter> KeepAlive = AsShared();
+
+	// The per-file callbacks hold what they import for, e.g. the session, so they are dropped before anyone is told
+	Pending.Reset();
+	NumLaunched = 0;
+	NumCompleted = 0;
+	if (OnFinished)
+	{
+		TFunction<void()> Finished = MoveTemp(OnFinished);
+		Finished();
+	}
+}
+
+void FCharmInterchangeImporter::WaitUntilDone()
+{
+	TSharedRef<FCharmInterchangeImporter> KeepAlive = AsShared();
+	while (!IsDone())
+	{
+		FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+		FTSTicker::GetCoreTicker().Tick(FApp::GetDeltaTime());
+		FPlatformProcess::Sleep(0.01f);
+	}
+}
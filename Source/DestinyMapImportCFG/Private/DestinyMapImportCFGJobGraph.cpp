@@ -0,0 +1,74 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "DestinyMapImportCFGJobGraph.h"
+#include "HAL/PlatformTime.h"
+#include "Algo/BinarySearch.h"
+
+int32 FCharmImportJobGraph::AddStage(const FString& StageName, TFunction<void()> Work, const TArray<int32>& Dependencies)
+{
+	return Stages.Add({ StageName, MoveTemp(Work), Dependencies });
+}
+
+void FCharmImportJobGraph::AddDependency(int32 Stage, int32 Dependency)
+{
+	check(Stages.IsValidIndex(Stage));
+	Stages[Stage].Dependencies.AddUnique(Dependency);
+}
+
+void FCharmImportJobGraph::Run()
+{
+	// Kahn's algorithm: count what each stage still waits for and who waits for it
+	TArray<int32> RemainingDependencies;
+	TArray<TArray<int32>> Dependents;
+	RemainingDependencies.SetNumZeroed(Stages.Num());
+	Dependents.SetNum(Stages.Num());
+	for (int32 StageIndex = 0; StageIndex < Stages.Num(); ++StageIndex)
+	{
+		for (int32 Dependency : Stages[StageIndex].Dependencies)
+		{
+			checkf(Stages.IsValidIndex(Dependency) && Dependency != StageIndex, TEXT("Stage %s has an invalid dependency"), *Stages[StageIndex].Name);
+			Dependents[Dependency].Add(StageIndex);
+			++RemainingDependencies[StageIndex];
+		}
+	}
+
+	TArray<int32> Ready;
+	for (int32 StageIndex = 0; StageIndex < Stages.Num(); ++StageIndex)
+	{
+		if (RemainingDependencies[StageIndex] == 0) Ready.Add(StageIndex);
+	}
+
+	TArray<int32> RunOrder;
+	RunOrder.Reserve(Stages.Num());
+	const double GraphStart = FPlatformTime::Seconds();
+	while (Ready.Num() > 0)
+	{
+		// Lowest index first, so independent stages keep the order they were added in
+		const int32 StageIndex = Ready[0];
+		Ready.RemoveAt(0);
+
+		FStage& Stage = Stages[StageIndex];
+		const double StageStart = FPlatformTime::Seconds();
+		Stage.Work();
+		Stage.Seconds = FPlatformTime::Seconds() - StageStart;
+		RunOrder.Add(StageIndex);
+
+		for (int32 Dependent : Dependents[StageIndex])
+		{
+			if (--RemainingDependencies[Dependent] == 0)
+			{
+				const int32 InsertAt = Algo::LowerBound(Ready, Dependent);
+				Ready.Insert(Dependent, InsertAt);
+			}
+		}
+	}
+	const double GraphSeconds = FPlatformTime::Seconds() - GraphStart;
+	checkf(RunOrder.Num() == Stages.Num(), TEXT("%s has a dependency cycle, %d of %d stages ran"), *Name, RunOrder.Num(), Stages.Num());
+
+	UE_LOG(LogTemp, Log, TEXT("%s finished in %.2f s"), *Name, GraphSeconds);
+	for (int32 StageIndex : RunOrder)
+	{
+		const FStage& Stage = Stages[StageIndex];
+		UE_LOG(LogTemp, Log, TEXT("  %-10s %8.2f s  %5.1f%%"), *Stage.Name, Stage.Seconds, GraphSeconds > 0.0 ? 100.0 * Stage.Seconds / GraphSeconds : 0.0);
+	}
+}
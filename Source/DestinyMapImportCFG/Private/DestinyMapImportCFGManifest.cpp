@@ -0,0 +1,146 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "DestinyMapImportCFGManifest.h"
+#include "HAL/FileManager.h"
+#include "Misc/Paths.h"
+#include "Async/Async.h"
+#include "Templates/UniquePtr.h"
+
+namespace
+{
+	const uint32 ManifestMagic = 0x4D494343; // "CCIM"
+	const uint32 ManifestVersion = 1;
+
+	FArchive& operator<<(FArchive& Ar, FCharmManifestEntry& Entry)
+	{
+		return Ar << Entry.SourcePath << Entry.SourceSize << Entry.SourceTicks << Entry.SourceHash << Entry.AssetPath;
+	}
+}
+
+FCharmImportManifest::FCharmImportManifest(const FString& InManifestPath)
+	: ManifestPath(InManifestPath)
+{
+	Load();
+}
+
+FCharmImportManifest::~FCharmImportManifest()
+{
+	Save();
+}
+
+FString FCharmImportManifest::GetManifestPath(const FString& FolderName)
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("DestinyMapImportCFG"), FolderName + TEXT(".manifest"));
+}
+
+void FCharmImportManifest::Load()
+{
+	TUniquePtr<FArchive> Ar(IFileManager::Get().CreateFileReader(*ManifestPath));
+	if (!Ar) return;
+
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	*Ar << Magic << Version;
+	if (Magic != ManifestMagic || Version != ManifestVersion) return;
+
+	int32 EntryCount = 0;
+	*Ar << EntryCount;
+	for (int32 Index = 0; Index < EntryCount && !Ar->IsError(); ++Index)
+	{
+		FCharmManifestEntry Entry;
+		*Ar << Entry;
+		if (!Ar->IsError()) Entries.Add(Entry.SourcePath, MoveTemp(Entry));
+	}
+	if (Ar->IsError())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Import manifest %s is damaged, every source will be checked again"), *ManifestPath);
+		Entries.Reset();
+	}
+}
+
+void FCharmImportManifest::CollectHashes()
+{
+	for (TPair<FString, TFuture<FMD5Hash>>& Pair : PendingHashes)
+	{
+		if (FCharmManifestEntry* Entry = Entries.Find(Pair.Key)) Entry->SourceHash = Pair.Value.Get();
+	}
+	PendingHashes.Reset();
+}
+
+void FCharmImportManifest::Save()
+{
+	if (!bDirty) return;
+	CollectHashes();
+
+	// Written to a temp file first so a crash mid-write leaves the previous manifest intact
+	const FString TempPath = ManifestPath + TEXT(".tmp");
+	TUniquePtr<FArchive> Ar(IFileManager::Get().CreateFileWriter(*TempPath));
+	if (!Ar)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Failed to write import manifest %s"), *ManifestPath);
+		return;
+	}
+
+	uint32 Magic = ManifestMagic;
+	uint32 Version = ManifestVersion;
+	int32 EntryCount = Entries.Num();
+	*Ar << Magic << Version << EntryCount;
+	for (TPair<FString, FCharmManifestEntry>& Pair : Entries)
+	{
+		*Ar << Pair.Value;
+	}
+
+	const bool bWritten = Ar->Close();
+	Ar.Reset();
+	if (!bWritten || !IFileManager::Get().Move(*ManifestPath, *TempPath, true))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Failed to write import manifest %s"), *ManifestPath);
+		IFileManager::Get().Delete(*TempPath);
+		return;
+	}
+	bDirty = false;
+}
+
+bool FCharmImportManifest::IsUpToDate(const FString& SourcePath, const FString& AssetPath)
+{
+	FCharmManifestEntry* Entry = Entries.Find(SourcePath);
+	if (!Entry)
+	{
+		Record(SourcePath, AssetPath);
+		return true;
+	}
+
+	const int64 SourceSize = IFileManager::Get().FileSize(*SourcePath);
+	const int64 SourceTicks = IFileManager::Get().GetTimeStamp(*SourcePath).GetTicks();
+	if (SourceSize < 0 || SourceSize != Entry->SourceSize || AssetPath != Entry->AssetPath) return false;
+	if (SourceTicks == Entry->SourceTicks) return true;
+
+	// Same size, new timestamp: a re-export often rewrites identical files, only the content decides
+	if (TFuture<FMD5Hash>* Pending = PendingHashes.Find(SourcePath))
+	{
+		Entry->SourceHash = Pending->Get();
+		PendingHashes.Remove(SourcePath);
+	}
+	if (!Entry->SourceHash.IsValid() || FMD5Hash::HashFile(*SourcePath) != Entry->SourceHash) return false;
+	Entry->SourceTicks = SourceTicks;
+	bDirty = true;
+	return true;
+}
+
+void FCharmImportManifest::Record(const FString& SourcePath, const FString& AssetPath)
+{
+	FCharmManifestEntry& Entry = Entries.FindOrAdd(SourcePath);
+	Entry.SourcePath = SourcePath;
+	Entry.SourceSize = IFileManager::Get().FileSize(*SourcePath);
+	Entry.SourceTicks = IFileManager::Get().GetTimeStamp(*SourcePath).GetTicks();
+	Entry.SourceHash = FMD5Hash();
+	Entry.AssetPath = AssetPath;
+	bDirty = true;
+
+	// A source rewritten while it is hashed keeps no hash, so its next timestamp change re-imports it
+	PendingHashes.Add(SourcePath, Async(EAsyncExecution::ThreadPool, [SourcePath, SourceTicks = Entry.SourceTicks]()
+	{
+		FMD5Hash Hash = FMD5Hash::HashFile(*SourcePath);
+		return IFileManager::Get().GetTimeStamp(*SourcePath).GetTicks() == SourceTicks ? Hash : FMD5Hash();
+	}));
+}
@@ -0,0 +1,405 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "DestinyMapImportCFGReader.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Templates/UniquePtr.h"
+
+namespace
+{
+	class FCharmCFGParser
+	{
+	public:
+		FCharmCFGParser(TSharedRef<TJsonReader<UTF8CHAR>> InReader, const FCharmCFGCallbacks& InCallbacks, const FString& InConfigPath)
+			: Reader(InReader)
+			, Callbacks(InCallbacks)
+			, ConfigPath(InConfigPath)
+		{
+		}
+
+		bool Parse()
+		{
+			EJsonNotation Notation;
+			if (!Reader->ReadNext(Notation) || Notation != EJsonNotation::ObjectStart)
+			{
+				return Fail(TEXT("root is not an object"));
+			}
+
+			while (!bStopped && Reader->ReadNext(Notation))
+			{
+				switch (Notation)
+				{
+				case EJsonNotation::String:
+					ReadHeaderField(Reader->GetIdentifier(), Reader->GetValueAsString());
+					break;
+
+				case EJsonNotation::ObjectStart:
+					if (Reader->GetIdentifier() == TEXT("Parts"))
+					{
+						if (!ReadParts()) return false;
+					}
+					else if (Reader->GetIdentifier() == TEXT("Instances"))
+					{
+						if (!ReadInstances()) return false;
+					}
+					else if (!Skip())
+					{
+						return false;
+					}
+					break;
+
+				case EJsonNotation::ArrayStart:
+					if (!Skip()) return false;
+					break;
+
+				case EJsonNotation::ObjectEnd:
+					// End of the root object, anything still waiting on the header goes out now
+					SendHeader();
+					return true;
+
+				case EJsonNotation::Error:
+					return Fail(Reader->GetErrorMessage());
+
+				default:
+					break;
+				}
+			}
+
+			return bStopped || Fail(Reader->GetErrorMessage());
+		}
+
+	private:
+		void ReadHeaderField(const FString& Identifier, const FString& Value)
+		{
+			if (Identifier == TEXT("ExportType")) Header.ExportType = Value;
+			else if (Identifier == TEXT("Type")) Header.Type = Value;
+			else if (Identifier == TEXT("MeshName")) Header.MeshName = Value;
+			else if (Identifier == TEXT("AssetsPath")) Header.AssetsPath = Value;
+		}
+
+		// Parts and Instances are only handed out after the header, if they come first they are held back until it is complete.
+		// MeshName names the outliner folder, so it is waited for too; a CFG without it gets its header when the root object closes
+		void BeginSection()
+		{
+			if (!bHeaderSent && !Header.ExportType.IsEmpty() && !Header.Type.IsEmpty() && !Header.MeshName.IsEmpty() && !Header.AssetsPath.IsEmpty())
+			{
+				SendHeader();
+			}
+		}
+
+		void SendHeader()
+		{
+			if (bHeaderSent) return;
+			bHeaderSent = true;
+
+			if (Callbacks.OnHeader && !Callbacks.OnHeader(Header))
+			{
+				bStopped = true;
+				return;
+			}
+
+			for (TPair<FString, TArray<FString>>& Part : PendingParts)
+			{
+				EmitPart(Part.Key, Part.Value);
+			}
+			for (TPair<FString, FCharmInstanceBuffer>& Instances : PendingInstances)
+			{
+				EmitInstances(Instances.Key, Instances.Value);
+			}
+			PendingParts.Empty();
+			PendingInstances.Empty();
+		}
+
+		void EmitPart(const FString& ModelName, TArray<FString>& MaterialRefs)
+		{
+			if (!bHeaderSent)
+			{
+				PendingParts.Emplace(ModelName, MoveTemp(MaterialRefs));
+			}
+			else if (Callbacks.OnPart)
+			{
+				Callbacks.OnPart(ModelName, MaterialRefs);
+			}
+		}
+
+		void EmitInstances(const FString& MeshName, FCharmInstanceBuffer& Instances)
+		{
+			if (!bHeaderSent)
+			{
+				PendingInstances.Emplace(MeshName, MoveTemp(Instances));
+			}
+			else if (Callbacks.OnInstances)
+			{
+				Callbacks.OnInstances(MeshName, Instances);
+			}
+		}
+
+		bool ReadParts()
+		{
+			BeginSection();
+
+			EJsonNotation Notation;
+			while (!bStopped && Reader->ReadNext(Notation))
+			{
+				if (Notation == EJsonNotation::ObjectEnd) return true;
+
+				if (Notation == EJsonNotation::ObjectStart)
+				{
+					FString ModelName = Reader->GetIdentifier();
+					TArray<FString> MaterialRefs;
+					while (Reader->ReadNext(Notation) && Notation != EJsonNotation::ObjectEnd)
+					{
+						if (Notation == EJsonNotation::String)
+						{
+							MaterialRefs.Add(Reader->GetValueAsString());
+						}
+						else if (Notation == EJsonNotation::ObjectStart || Notation == EJsonNotation::ArrayStart)
+						{
+							if (!Skip()) return false;
+						}
+						else if (Notation == EJsonNotation::Error)
+						{
+							return Fail(Reader->GetErrorMessage());
+						}
+					}
+					if (Notation != EJsonNotation::ObjectEnd) return Fail(Reader->GetErrorMessage());
+
+					EmitPart(ModelName, MaterialRefs);
+				}
+				else if (Notation == EJsonNotation::ArrayStart)
+				{
+					if (!Skip()) return false;
+				}
+				else if (Notation == EJsonNotation::Error)
+				{
+					return Fail(Reader->GetErrorMessage());
+				}
+			}
+			return bStopped || Fail(Reader->GetErrorMessage());
+		}
+
+		bool ReadInstances()
+		{
+			BeginSection();
+
+			// Nobody wants the placements, e.g. the collect pass only needs Parts: skip the tokens without decoding them
+			if (!Callbacks.OnInstances) return Skip();
+
+			EJsonNotation Notation;
+			while (!bStopped && Reader->ReadNext(Notation))
+			{
+				if (Notation == EJsonNotation::ObjectEnd) return true;
+
+				if (Notation == EJsonNotation::ArrayStart)
+				{
+					FString MeshName = Reader->GetIdentifier();
+					FCharmInstanceBuffer Instances;
+					while (Reader->ReadNext(Notation) && Notation != EJsonNotation::ArrayEnd)
+					{
+						if (Notation == EJsonNotation::ObjectStart)
+						{
+							if (!ReadInstance(Instances)) return false;
+						}
+						else if (Notation == EJsonNotation::ArrayStart)
+						{
+							if (!Skip()) return false;
+						}
+						else if (Notation == EJsonNotation::Error)
+						{
+							return Fail(Reader->GetErrorMessage());
+						}
+					}
+					if (Notation != EJsonNotation::ArrayEnd) return Fail(Reader->GetErrorMessage());
+
+					EmitInstances(MeshName, Instances);
+				}
+				else if (Notation == EJsonNotation::ObjectStart)
+				{
+					if (!Skip()) return false;
+				}
+				else if (Notation == EJsonNotation::Error)
+				{
+					return Fail(Reader->GetErrorMessage());
+				}
+			}
+			return bStopped || Fail(Reader->GetErrorMessage());
+		}
+
+		bool ReadInstance(FCharmInstanceBuffer& Instances)
+		{
+			float Translation[3] = { 0.f, 0.f, 0.f };
+			float Rotation[4] = { 0.f, 0.f, 0.f, 1.f };
+			float Scale[3] = { 1.f, 1.f, 1.f };
+			bool bHasTranslation = false;
+			bool bHasRotation = false;
+			bool bHasScale = false;
+
+			EJsonNotation Notation;
+			while (Reader->ReadNext(Notation) && Notation != EJsonNotation::ObjectEnd)
+			{
+				if (Notation == EJsonNotation::ArrayStart)
+				{
+					float* Target = nullptr;
+					bool* bFound = nullptr;
+					int32 Capacity = 0;
+					const FString& Identifier = Reader->GetIdentifier();
+					if (Identifier == TEXT("Translation")) { Target = Translation; bFound = &bHasTranslation; Capacity = 3; }
+					else if (Identifier == TEXT("Rotation")) { Target = Rotation; bFound = &bHasRotation; Capacity = 4; }
+					else if (Identifier == TEXT("Scale")) { Target = Scale; bFound = &bHasScale; Capacity = 3; }
+
+					int32 Count = 0;
+					while (Reader->ReadNext(Notation) && Notation != EJsonNotation::ArrayEnd)
+					{
+						if (Notation == EJsonNotation::Number)
+						{
+							if (Target && Count < Capacity) Target[Count] = (float)Reader->GetValueAsNumber();
+							++Count;
+						}
+						else if (Notation == EJsonNotation::ObjectStart || Notation == EJsonNotation::ArrayStart)
+						{
+							if (!Skip()) return false;
+						}
+						else if (Notation == EJsonNotation::Error)
+						{
+							return Fail(Reader->GetErrorMessage());
+						}
+					}
+					if (Notation != EJsonNotation::ArrayEnd) return Fail(Reader->GetErrorMessage());
+					if (bFound) *bFound = Count >= Capacity;
+				}
+				else if (Notation == EJsonNotation::ObjectStart)
+				{
+					if (!Skip()) return false;
+				}
+				else if (Notation == EJsonNotation::Error)
+				{
+					return Fail(Reader->GetErrorMessage());
+				}
+			}
+			if (Notation != EJsonNotation::ObjectEnd) return Fail(Reader->GetErrorMessage());
+
+			if (bHasTranslation && bHasRotation && bHasScale)
+			{
+				Instances.Add(Translation, Rotation, Scale);
+			}
+			else
+			{
+				UE_LOG(LogTemp, Warning, TEXT("Skipping instance with missing Translation/Rotation/Scale in %s"), *ConfigPath);
+			}
+			return true;
+		}
+
+		// Skips the object or array whose start token was just read
+		bool Skip()
+		{
+			int32 Depth = 1;
+			EJsonNotation Notation;
+			while (Depth > 0 && Reader->ReadNext(Notation))
+			{
+				if (Notation == EJsonNotation::ObjectStart || Notation == EJsonNotation::ArrayStart) ++Depth;
+				else if (Notation == EJsonNotation::ObjectEnd || Notation == EJsonNotation::ArrayEnd) --Depth;
+				else if (Notation == EJsonNotation::Error) break;
+			}
+			return Depth == 0 || Fail(Reader->GetErrorMessage());
+		}
+
+		bool Fail(const FString& Reason)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Failed to parse CFG %s: %s"), *ConfigPath, *Reason);
+			return false;
+		}
+
+		TSharedRef<TJsonReader<UTF8CHAR>> Reader;
+		const FCharmCFGCallbacks& Callbacks;
+		const FString& ConfigPath;
+
+		FCharmCFGHeader Header;
+		bool bHeaderSent = false;
+		bool bStopped = false;
+		TArray<TPair<FString, TArray<FString>>> PendingParts;
+		TArray<TPair<FString, FCharmInstanceBuffer>> PendingInstances;
+	};
+}
+
+bool FCharmCFGReader::Read(const FString& ConfigPath, const FCharmCFGCallbacks& Callbacks)
+{
+	TUniquePtr<FArchive> FileReader(IFileManager::Get().CreateFileReader(*ConfigPath));
+	if (!FileReader)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Failed to open CFG %s"), *ConfigPath);
+		return false;
+	}
+
+	// Skip a UTF-8 byte order mark, the JSON reader only wants the text
+	if (FileReader->TotalSize() >= 3)
+	{
+		uint8 ByteOrderMark[3];
+		FileReader->Serialize(ByteOrderMark, 3);
+		if (ByteOrderMark[0] != 0xEF || ByteOrderMark[1] != 0xBB || ByteOrderMark[2] != 0xBF)
+		{
+			FileReader->Seek(0);
+		}
+	}
+
+	FCharmCFGParser Parser(TJsonReaderFactory<UTF8CHAR>::Create(FileReader.Get()), Callbacks, ConfigPath);
+	return Parser.Parse();
+}
+
+bool FCharmCFGReader::ReadLights(const FString& LightsPath, TArray<FCharmLight>& OutLights)
+{
+	FString JsonRaw;
+	if (!FFileHelper::LoadFileToString(JsonRaw, *LightsPath))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Failed to load lights JSON from %s"), *LightsPath);
+		return false;
+	}
+
+	TSharedPtr<FJsonObject> RootObj;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(JsonRaw);
+	if (!FJsonSerializer::Deserialize(Reader, RootObj) || !RootObj.IsValid())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Failed to parse lights JSON"));
+		return false;
+	}
+
+	for (const auto& LightPair : RootObj->Values)
+	{
+		TSharedPtr<FJsonObject> LightObj = LightPair.Value->AsObject();
+		if (!LightObj.IsValid()) continue;
+
+		const TArray<TSharedPtr<FJsonValue>>* Instances;
+		if (!LightObj->TryGetArrayField(TEXT("Instances"), Instances)) continue;
+
+		FCharmLight& Light = OutLights.AddDefaulted_GetRef();
+		Light.Name = LightPair.Key;
+		Light.Type = LightObj->GetStringField(TEXT("Type"));
+
+		if (LightObj->HasTypedField<EJson::Array>(TEXT("Color")))
+		{
+			const TArray<TSharedPtr<FJsonValue>>& ColorArray = LightObj->GetArrayField(TEXT("Color"));
+			if (ColorArray.Num() >= 3)
+			{
+				Light.Color.R = ColorArray[0]->AsNumber();
+				Light.Color.G = ColorArray[1]->AsNumber();
+				Light.Color.B = ColorArray[2]->AsNumber();
+				if (ColorArray.Num() >= 4)
+					Light.Color.A = ColorArray[3]->AsNumber();
+			}
+		}
+
+		if (LightObj->HasTypedField<EJson::Number>(TEXT("Attenuation")))
+		{
+			Light.Attenuation = LightObj->GetNumberField(TEXT("Attenuation")) * 1000.f;
+		}
+
+		if (LightObj->HasTypedField<EJson::String>(TEXT("Cookie")))
+		{
+			Light.Cookie = LightObj->GetStringField(TEXT("Cookie"));
+		}
+
+		Light.Instances.DecodeJson(*Instances);
+	}
+	return true;
+}
@@ -0,0 +1,114 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "DestinyMapImportCFGTextures.h"
+#include "IImageWrapperModule.h"
+#include "ImageCoreUtils.h"
+#include "Async/Async.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Modules/ModuleManager.h"
+#include "Engine/Texture2D.h"
+#include "EditorFramework/AssetImportData.h"
+#include "AssetRegistry/AssetRegistryModule.h"
+
+TextureCompressionSettings FCharmTextureDecoder::GetCompressionSettings(const FString& Hash, const FString& Format)
+{
+	if (Format == "BC1_UNORM_SRGB") return TC_Default;
+	if (Format == "BC7_UNORM_SRGB" || Format == "BC7_UNORM") return TC_BC7;
+	if (Format == "BC5_UNORM") return TC_Normalmap;
+	if (Format == "BC4_UNORM") return TC_Alpha;
+
+	UE_LOG(LogTemp, Warning, TEXT("Unknown Texture Format for Texture %s: %s"), *Hash, *Format);
+	return TC_Default;
+}
+
+void FCharmTextureDecoder::DecodeAll(const TArray<FCharmTextureRequest>& Requests, int32 MaxInFlight, TFunctionRef<void(FCharmDecodedTexture&)> OnDecoded)
+{
+	// The module has to be loaded here, worker threads may not load modules
+	IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>("ImageWrapper");
+
+	auto LaunchDecode = [&ImageWrapperModule](const FCharmTextureRequest& Request)
+	{
+		return Async(EAsyncExecution::ThreadPool, [&ImageWrapperModule, Request]()
+		{
+			FCharmDecodedTexture Decoded;
+			Decoded.Request = Request;
+
+			TArray64<uint8> CompressedData;
+			if (FFileHelper::LoadFileToArray(CompressedData, *Request.SourcePath))
+			{
+				Decoded.bDecoded = ImageWrapperModule.DecompressImage(CompressedData.GetData(), CompressedData.Num(), Decoded.Image);
+			}
+			return Decoded;
+		});
+	};
+
+	// Results are consumed in order, the next decode is only queued once a slot frees up so memory stays bounded
+	MaxInFlight = FMath::Max(MaxInFlight, 1);
+	TArray<TFuture<FCharmDecodedTexture>> InFlight;
+	InFlight.Reserve(Requests.Num());
+	for (int32 Index = 0; Index < FMath::Min(MaxInFlight, Requests.Num()); ++Index)
+	{
+		InFlight.Add(LaunchDecode(Requests[Index]));
+	}
+
+	for (int32 Index = 0; Index < Requests.Num(); ++Index)
+	{
+		// Consume moves the decoded image out and releases the future, Get would copy the whole mip on the game thread
+		FCharmDecodedTexture Decoded = InFlight[Index].Consume();
+
+		if (Index + MaxInFlight < Requests.Num())
+		{
+			InFlight.Add(LaunchDecode(Requests[Index + MaxInFlight]));
+		}
+
+		if (!Decoded.bDecoded)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Failed to decode texture source %s"), *Decoded.Request.SourcePath);
+		}
+		OnDecoded(Decoded);
+	}
+}
+
+UTexture2D* FCharmTextureDecoder::CreateTexture(const FString& PackagePath, const FCharmDecodedTexture& Decoded)
+{
+	check(IsInGameThread());
+	if (!Decoded.bDecoded) return nullptr;
+
+	const FImage& Image = Decoded.Image;
+	ETextureSourceFormat SourceFormat = FImageCoreUtils::ConvertToTextureSourceFormat(Image.Format);
+	if (SourceFormat == TSF_Invalid)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Unsupported pixel format in texture source %s"), *Decoded.Request.SourcePath);
+		return nullptr;
+	}
+
+	// A stale texture is re-initialised in place, since a second object under the same name would fail to create
+	UPackage* Package = CreatePackage(*PackagePath);
+	if (FPackageName::DoesPackageExist(PackagePath)) Package->FullyLoad();
+	UObject* Existing = FindObject<UObject>(Package, *Decoded.Request.Hash);
+	UTexture2D* Texture = Cast<UTexture2D>(Existing);
+	if (Existing && !Texture)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("%s already holds a %s, not a texture"), *PackagePath, *Existing->GetClass()->GetName());
+		return nullptr;
+	}
+	const bool bCreated = Texture == nullptr;
+	if (bCreated)
+	{
+		Texture = NewObject<UTexture2D>(Package, *Decoded.Request.Hash, RF_Public | RF_Standalone);
+	}
+	else
+	{
+		Texture->PreEditChange(nullptr);
+	}
+	Texture->Source.Init(Image.SizeX, Image.SizeY, 1, 1, SourceFormat, Image.RawData.GetData());
+	Texture->SRGB = Decoded.Request.bSRGB;
+	Texture->CompressionSettings = GetCompressionSettings(Decoded.Request.Hash, Decoded.Request.Format);
+	Texture->AssetImportData->Update(Decoded.Request.SourcePath);
+
+	Texture->PostEditChange();
+	Texture->MarkPackageDirty();
+	if (bCreated) FAssetRegistryModule::AssetCreated(Texture);
+	return Texture;
+}
@@ -10,10 +10,15 @@
 #include "Engine/SkinnedAssetCommon.h"
 #include "Widgets/DeclarativeSyntaxSupport.h"
 #include "Modules/ModuleManager.h"
+#include "Engine/World.h"
+#include "DestinyMapImportCFGSession.h"
 
 
 class FToolBarBuilder;
 class FMenuBuilder;
+struct FCharmCFGWork;
+struct FCharmMaterialWork;
+struct FCharmTextureRequest;
 /*
 UENUM(BlueprintType)
 enum EImportMapTarget : uint8
@@ -24,14 +29,6 @@ enum EImportMapTarget : uint8
 	IMT_MAX,
 };
 */
-UENUM(BlueprintType)
-enum class ETextureFormat : uint8
-{
-	TF_Auto     UMETA(DisplayName = "Automatic"),
-	TF_PNG      UMETA(DisplayName = "*.PNG"),
-	TF_TIF      UMETA(DisplayName = "*.TIF/*.TIFF"),
-	TF_TGA      UMETA(DisplayName = "*.TGA")
-};
 
 
 DECLARE_DELEGATE_OneParam(FOnFormatChanged, ETextureFormat)
@@ -142,27 +139,38 @@ public:
 	void PluginButtonClicked();
 	void ImportCharmCFGButtonClicked();
 	void BuildMapButtonClicked();
-	void FImportMaterials(FString ConfigPath, FStaticMaterial& StaticMaterialSlot, FSkeletalMaterial& SkeletalMaterialSlot, TSharedPtr<FJsonObject> MaterialJson, bool isStaticMesh, UTextureFactory* TextureFactory);
-	void FImportTextures(TSharedPtr<FJsonObject> MaterialJson, FString ConfigPath, UTextureFactory* TextureFactory);
-	void FImportToMap(TArray<FString> OutFiles);
-	void FImportLightingToMap(FString ConfigPath);
-
-
-	// Import vars
-	bool bImportTextures = true;
-	bool bImportMaterials = true;
-	bool bUseCurrentMap = true;
-	bool bMaterialGen = true UMETA(EditCondition = "bImportMaterials");
-	bool bDiffuseApply = true UMETA(EditCondition = "bSkipMaterialGen");
-	float fMapScale = 100.f;
-	bool bImportAtmosphere = false;
-	bool bImportCubeMap = false;
-	float fLightIntensity = 10.0f;
-	bool bImportLights = true;
-	ETextureFormat SelectedFormat = ETextureFormat::TF_Auto;
-	FString CFGFolderName;
-	FStaticMaterial FinalStaticMaterialSlot;
-	FSkeletalMaterial FinalSkeletalMaterialSlot;
+	TSharedRef<FCharmImportSession> FBeginImportSession();
+	const FCharmAssetsIndex& FGetAssetsIndex(FCharmImportSession& Session, const FString& AssetsPath);
+	bool FDoesAssetExist(FCharmImportSession& Session, const FString& PackageFolder, const FString& AssetName);
+	void FNoteImportedAsset(FCharmImportSession& Session, const FString& AssetPath);
+	FCharmImportManifest& FGetImportManifest(FCharmImportSession& Session, const FString& FolderName);
+	void FImportModels(const TSharedRef<FCharmImportSession>& Session, TArray<FString> OutFiles);
+	static bool FParseCFGWork(const FCharmImportSettings& ImportSettings, FCharmCFGWork& Work);
+	bool FCollectCFGWork(FCharmImportSession& Session, FCharmCFGWork& Work);
+	void FMergeMaterialWork(const TArray<FCharmCFGWork>& WorkSet, TArray<FCharmMaterialWork>& OutMaterialWorkSet);
+	void FWaitForPendingImports(FCharmImportSession& Session);
+	void FFinishPendingImports(const TSharedRef<FCharmImportSession>& Session);
+	void FBindImportedMaterials(FCharmImportSession& Session, const FCharmCFGContext& Context, const TArray<UObject*>& ImportedAssets, UTextureFactory* TextureFactory);
+	void FPrefetchTextures(FCharmImportSession& Session, const FCharmCFGContext& Context, const TArray<FString>& MaterialRefs, UTextureFactory* TextureFactory);
+	UMaterialInterface* FGetOrCreateMaterial(FCharmImportSession& Session, const FCharmCFGContext& Context, FString MaterialRef, TSharedPtr<FJsonObject> TexturesJson, UTextureFactory* TextureFactory);
+	void FImportTextures(FCharmImportSession& Session, const FCharmCFGContext& Context, TSharedPtr<FJsonObject> TexturesJson, UTextureFactory* TextureFactory);
+	void FImportTextureSource(FCharmImportSession& Session, FCharmImportManifest& Manifest, const FString& TextureImportPath, const FCharmTextureRequest& Request, UTextureFactory* TextureFactory);
+	TSharedPtr<FJsonObject> FLoadMaterialTextures(FCharmImportSession& Session, const FString& AssetsPath, FString MaterialRef);
+	UMaterialInterface* FCreateMaterialInstance(FCharmImportSession& Session, const FCharmCFGContext& Context, FString MaterialRef, TSharedPtr<FJsonObject> TexturesJson, UTextureFactory* TextureFactory, class UMaterialInstanceConstant* ExistingInstance = nullptr);
+	UMaterial* FGetMasterMaterial(FCharmImportSession& Session, const TArray<UTexture2D*>& Textures);
+	void FQueueMaterialCompile(FCharmImportSession& Session, UMaterialInterface* Material);
+	void FFlushMaterialCompiles(FCharmImportSession& Session);
+	void FBuildMap(TArray<FString> OutFiles);
+	void FImportToMap(FCharmImportSession& Session, TArray<FString> OutFiles);
+	void FPlaceMeshInstances(FCharmImportSession& Session, const FCharmCFGContext& Context, const FString& OutlinerFolder, const FString& MeshName, struct FCharmInstanceBuffer& InstanceBuffer);
+	void FImportLightingToMap(FCharmImportSession& Session, FString ConfigPath);
+	FActorSpawnParameters FMakePlacementParameters(FCharmImportSession& Session, const FString& Label, const FString& OutlinerFolder, const FString& DataLayer);
+	void FRegisterPlacedActor(FCharmImportSession& Session, AActor* Actor, const FString& Label, const FString& OutlinerFolder, const FString& DataLayer);
+	void FMarkPlacedLevelsDirty(FCharmImportSession& Session);
+	void FAssignDataLayers(FCharmImportSession& Session, UWorld* World);
+
+	// Import vars, copied into each FCharmImportSession when it starts
+	FCharmImportSettings Settings;
 private:
 
 	void RegisterMenus();
@@ -171,4 +179,5 @@ private:
 
 private:
 	TSharedPtr<class FUICommandList> PluginCommands;
+	TArray<TSharedRef<FCharmImportSession>> RunningSessions; // sessions whose Interchange import is still in flight
 };
@@ -0,0 +1,37 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DestinyMapImportCFGSession.h"
+
+/**
+ * Listing of a Charm export's Textures, Models/<Type> and Materials folders, scanned once per import
+ * session so existence checks and format probing are map lookups instead of filesystem stats.
+ */
+class FCharmAssetsIndex
+{
+public:
+	void Build(const FString& InAssetsPath);
+
+	/** Textures/<Hash>.<ext> in the order SelectedFormat prefers, empty if no source exists */
+	FString FindTextureSource(const FString& Hash, ETextureFormat SelectedFormat) const;
+
+	/** Models/<Type>/<ModelName>.fbx exists */
+	bool HasModel(const FString& Type, const FString& ModelName) const;
+
+	/** Number of consecutive Models/<Type>/<ModelName>_<N>.fbx chunks starting at 0 */
+	int32 GetChunkCount(const FString& Type, const FString& ModelName) const;
+
+	/** Materials/<MaterialRef>.json exists */
+	bool HasMaterial(const FString& MaterialRef) const;
+
+	const FString& GetAssetsPath() const { return AssetsPath; }
+
+private:
+	FString AssetsPath;
+	TMap<FString, uint8> TextureFormats; // texture hash -> mask of the source extensions present
+	TMap<FString, TSet<FString>> ModelFiles; // Type -> fbx names without extension
+	TMap<FString, int32> ChunkCounts; // <Type>/<ModelName> -> consecutive chunk count
+	TSet<FString> MaterialRefs;
+};
@@ -0,0 +1,24 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DestinyMapImportCFGReader.h"
+
+/**
+ * Binary sidecar next to each CFG (<file>.cfgcache) holding the already parsed header, parts,
+ * instance transforms and light table. The sidecar remembers the size, timestamp and MD5 of its
+ * source and is rebuilt whenever the source changes; otherwise it is memory mapped and replayed
+ * so repeated builds never touch the JSON again.
+ */
+class FCharmCFGCache
+{
+public:
+	/** Same contract as FCharmCFGReader::Read, served from the sidecar when it is up to date */
+	static bool Read(const FString& ConfigPath, const FCharmCFGCallbacks& Callbacks);
+
+	/** Same contract as FCharmCFGReader::ReadLights, served from the sidecar when it is up to date */
+	static bool ReadLights(const FString& LightsPath, TArray<FCharmLight>& OutLights);
+
+	static FString GetCachePath(const FString& SourcePath);
+};
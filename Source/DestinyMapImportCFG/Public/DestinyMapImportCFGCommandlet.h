@@ -0,0 +1,27 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "DestinyMapImportCFGCommandlet.generated.h"
+
+/**
+ * Runs the Charm CFG import without any UI, for build machines.
+ *
+ * UnrealEditor-Cmd.exe <Project>.uproject -run=DestinyMapImportCFG -cfg=<file.cfg>[+<file.cfg>...|<folder>]
+ *     [-map=/Game/Maps/<Map>] [-scale=100] [-textures=auto|png|tga|tif]
+ *     [-notextures] [-nomaterials] [-materialinstances] [-dedupematerials] [-nolights] [-nomodels] [-nobuild] [-noinstancing] [-nobulkplacement] [-worldpartition] [-cellsize=25600] [-decoratorcell=6400] [-decoratorcells3d] [-instancethreshold=8] [-nocfgcache] [-textureprefetch=32] [-importbatch=64] [-interchange] [-interchangejobs=8] [-sharedlibrary[=/Game/DestinyShared]]
+ *     -unattended -nullrhi
+ */
+UCLASS()
+class UDestinyMapImportCFGCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UDestinyMapImportCFGCommandlet();
+
+	//~ UCommandlet interface
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,30 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Dom/JsonValue.h"
+
+/**
+ * Instance transforms of one Charm mesh or light, stored as one float array per component (SoA)
+ * so the Charm -> UE conversion runs as a flat loop over contiguous memory.
+ */
+struct FCharmInstanceBuffer
+{
+	TArray<float> TX, TY, TZ;
+	TArray<float> QX, QY, QZ, QW;
+	TArray<float> SX, SY, SZ;
+
+	int32 Num() const { return TX.Num(); }
+
+	void Reset(int32 ExpectedNum = 0);
+	void Add(const float Translation[3], const float Rotation[4], const float Scale[3]);
+
+	/** Reads Translation, Rotation and Scale of every instance object, looking each field up once */
+	void DecodeJson(const TArray<TSharedPtr<FJsonValue>>& InstanceArray);
+
+	/** Charm is right handed: flips Y, mirrors the rotation to match and applies MapScale to translations */
+	void ConvertCharmToUnreal(float MapScale);
+
+	void ToTransforms(TArray<FTransform>& OutTransforms) const;
+};
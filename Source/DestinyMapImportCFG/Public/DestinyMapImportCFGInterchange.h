@@ -0,0 +1,52 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/StrongObjectPtr.h"
+
+class UInterchangeGenericAssetsPipeline;
+
+/**
+ * Imports Charm FBX files through Interchange instead of UFbxFactory. Translation and mesh builds run
+ * asynchronously, at most MaxInFlight files at a time, and each file's callback runs on the game thread
+ * once its assets exist so material binding overlaps the remaining imports.
+ */
+class FCharmInterchangeImporter : public TSharedFromThis<FCharmInterchangeImporter>
+{
+public:
+	/** Mirrors the UFbxFactory settings: uniform scale, static meshes only, combined meshes, no materials or textures */
+	FCharmInterchangeImporter(float ImportUniformScale, int32 InMaxInFlight);
+
+	void Enqueue(const FString& SourcePath, const FString& DestinationPath, TFunction<void(const TArray<UObject*>&)> OnImported);
+
+	/** Runs on the game thread once every queued file finished, after the queue and its callbacks were released */
+	void SetOnFinished(TFunction<void()> InOnFinished) { OnFinished = MoveTemp(InOnFinished); }
+
+	/** Starts the queued files, returns immediately */
+	void Start();
+
+	bool IsDone() const { return NumCompleted == Pending.Num(); }
+
+	/** Pumps game thread tasks until every queued file finished, for the commandlet */
+	void WaitUntilDone();
+
+private:
+	struct FPendingFile
+	{
+		FString SourcePath;
+		FString DestinationPath;
+		TFunction<void(const TArray<UObject*>&)> OnImported;
+	};
+
+	void LaunchNext();
+	void OnFileDone(int32 FileIndex, const TArray<UObject*>& ImportedObjects);
+	void Finish();
+
+	TStrongObjectPtr<UInterchangeGenericAssetsPipeline> Pipeline;
+	TArray<FPendingFile> Pending;
+	TFunction<void()> OnFinished;
+	int32 MaxInFlight = 1;
+	int32 NumLaunched = 0;
+	int32 NumCompleted = 0;
+};
@@ -0,0 +1,55 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DestinyMapImportCFGSession.h"
+
+/** What one CFG contributes to an import, gathered by the collect stage before any asset work starts */
+struct FCharmCFGWork
+{
+	FCharmCFGContext Context;
+	FString DestinationPath;
+	TArray<FString> ModelNames;
+	TSet<FString> MaterialRefs;
+	TArray<FString> PendingSourcePaths;
+	TArray<UObject*> ImportedAssets;
+};
+
+/** Materials of every collected CFG that writes to the same folder, merged so shared ones are handled once */
+struct FCharmMaterialWork
+{
+	FCharmCFGContext Context;
+	TSet<FString> MaterialRefs;
+};
+
+/**
+ * Import stages with explicit dependencies. Run orders them topologically: a stage starts once every stage it
+ * depends on finished, and stages that are ready together keep the order they were added in. Stages run on the
+ * calling (game) thread because they create and edit UObjects; each stage is timed and the timings are logged.
+ */
+class FCharmImportJobGraph
+{
+public:
+	explicit FCharmImportJobGraph(const FString& InName) : Name(InName) {}
+
+	/** Returns the stage index other stages use as a dependency */
+	int32 AddStage(const FString& StageName, TFunction<void()> Work, const TArray<int32>& Dependencies = {});
+
+	/** Makes Stage wait for Dependency, which may be added after it */
+	void AddDependency(int32 Stage, int32 Dependency);
+
+	void Run();
+
+private:
+	struct FStage
+	{
+		FString Name;
+		TFunction<void()> Work;
+		TArray<int32> Dependencies;
+		double Seconds = 0.0;
+	};
+
+	FString Name;
+	TArray<FStage> Stages;
+};
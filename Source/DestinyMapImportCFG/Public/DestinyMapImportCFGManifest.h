@@ -0,0 +1,53 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/SecureHash.h"
+#include "Async/Future.h"
+
+/** One source file the import consumed and the asset it became */
+struct FCharmManifestEntry
+{
+	FString SourcePath;
+	int64 SourceSize = -1;
+	int64 SourceTicks = 0;
+	FMD5Hash SourceHash;
+	FString AssetPath;
+};
+
+/**
+ * Record of every FBX, material JSON and texture source imported into one /Game/<FolderName>, kept in
+ * Saved/DestinyMapImportCFG/<FolderName>.manifest. Size and timestamp decide whether a source is
+ * unchanged; when only the timestamp moved (e.g. Charm re-exported the map) the MD5 decides, so a
+ * re-export only re-imports what actually differs. Recorded sources are hashed on the thread pool,
+ * the game thread only hashes a source whose timestamp moved. Written back when the manifest is destroyed.
+ */
+class FCharmImportManifest
+{
+public:
+	explicit FCharmImportManifest(const FString& InManifestPath);
+	~FCharmImportManifest();
+
+	static FString GetManifestPath(const FString& FolderName);
+
+	/**
+	 * Only asked for assets that exist: true if AssetPath was built from SourcePath as it is on disk now.
+	 * A source without an entry is assumed to have built the asset (imports from before the manifest) and is recorded.
+	 */
+	bool IsUpToDate(const FString& SourcePath, const FString& AssetPath);
+
+	/** SourcePath was just imported to AssetPath, its MD5 is taken in the background */
+	void Record(const FString& SourcePath, const FString& AssetPath);
+
+	void Save();
+
+private:
+	void Load();
+	void CollectHashes();
+
+	FString ManifestPath;
+	TMap<FString, FCharmManifestEntry> Entries; // source path -> entry
+	TMap<FString, TFuture<FMD5Hash>> PendingHashes; // source path -> hash still being taken
+	bool bDirty = false;
+};
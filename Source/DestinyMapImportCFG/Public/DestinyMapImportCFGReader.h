@@ -0,0 +1,56 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DestinyMapImportCFGInstances.h"
+
+/** Top level string fields of a Charm CFG */
+struct FCharmCFGHeader
+{
+	FString ExportType;
+	FString Type;
+	FString MeshName;
+	FString AssetsPath;
+};
+
+/** What the reader hands out while streaming a CFG, every callback is optional */
+struct FCharmCFGCallbacks
+{
+	/** Called once before any part or instance batch, returning false stops reading (e.g. not a Map export) */
+	TFunction<bool(const FCharmCFGHeader& Header)> OnHeader;
+
+	/** One entry of Parts: model name and the material hashes of its slots */
+	TFunction<void(const FString& ModelName, const TArray<FString>& MaterialRefs)> OnPart;
+
+	/** All placements of one Instances entry, still in Charm space; when unset Instances is skipped without being decoded */
+	TFunction<void(const FString& MeshName, FCharmInstanceBuffer& Instances)> OnInstances;
+};
+
+/** One entry of Rendering/Lights.json with all of its placements */
+struct FCharmLight
+{
+	FString Name;
+	FString Type;
+	FLinearColor Color = FLinearColor::White;
+	float Attenuation = 1000.f;
+	FString Cookie;
+	FCharmInstanceBuffer Instances;
+};
+
+/**
+ * Streaming reader for the Charm map CFG schema (ExportType, Type, MeshName, AssetsPath, Parts, Instances).
+ * Reads the UTF-8 file straight from disk token by token instead of building an FJsonObject DOM,
+ * so only one Instances entry is held in memory at a time as long as the header keys come first. Parts and
+ * Instances that precede ExportType, Type, MeshName or AssetsPath are buffered until the header is complete,
+ * at worst until the root object closes, because no callback may see them before OnHeader.
+ */
+class FCharmCFGReader
+{
+public:
+	/** Returns false if the file could not be opened or is not valid JSON */
+	static bool Read(const FString& ConfigPath, const FCharmCFGCallbacks& Callbacks);
+
+	/** Parses a Rendering/Lights.json file, lights without Instances are left out */
+	static bool ReadLights(const FString& LightsPath, TArray<FCharmLight>& OutLights);
+};
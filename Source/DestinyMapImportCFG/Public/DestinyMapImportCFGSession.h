@@ -0,0 +1,111 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/Paths.h"
+#include "UObject/WeakObjectPtrTemplates.h"
+#include "UObject/StrongObjectPtr.h"
+#include "Factories/TextureFactory.h"
+
+class FJsonObject;
+class FCharmAssetsIndex;
+class FCharmInterchangeImporter;
+class FCharmImportManifest;
+class UMaterial;
+class UMaterialInterface;
+class AActor;
+class ULevel;
+
+UENUM(BlueprintType)
+enum class ETextureFormat : uint8
+{
+	TF_Auto     UMETA(DisplayName = "Automatic"),
+	TF_PNG      UMETA(DisplayName = "*.PNG"),
+	TF_TIF      UMETA(DisplayName = "*.TIF/*.TIFF"),
+	TF_TGA      UMETA(DisplayName = "*.TGA")
+};
+
+/** Options of one import run, edited by the plugin window and the commandlet */
+struct FCharmImportSettings
+{
+	bool bImportTextures = true;
+	bool bImportMaterials = true;
+	bool bUseCurrentMap = true;
+	bool bMaterialGen = true;
+	bool bDiffuseApply = true;
+	bool bUseMaterialInstances = false;
+	bool bDedupeMaterials = false; // materials with the same texture hashes and colorspaces share one asset
+	float fMapScale = 100.f;
+	bool bImportAtmosphere = false;
+	bool bImportCubeMap = false;
+	float fLightIntensity = 10.0f;
+	bool bImportLights = true;
+	bool bInstanceMeshes = true;
+	bool bBulkPlacement = true; // map build pauses realtime viewports and labels actors without a per-actor Modify
+	bool bWorldPartitionOutput = false; // in a World Partition level, batches are split into grid cells and each Type gets a data layer
+	float WorldPartitionCellSize = 25600.f; // edge of one batch cell in Unreal units
+	float DecoratorCellSize = 6400.f; // decorators get one HISM per cell of this edge and mesh, 0 keeps one map-wide HISM per mesh
+	bool bDecoratorCells3D = false; // decorator cells are also split by height, for maps stacked vertically
+	int32 InstancingThreshold = 8;
+	bool bCacheParsedCFG = true;
+	int32 ModelImportBatchSize = 64;
+	bool bUseInterchange = false;
+	int32 InterchangeMaxInFlight = 8; // FBX files Interchange translates and builds at once
+	int32 TexturePrefetchDepth = 32; // decoded texture sources allowed to wait for the game thread
+	ETextureFormat SelectedFormat = ETextureFormat::TF_Auto;
+	bool bUseSharedLibrary = false;
+	FString SharedLibraryRoot = TEXT("/Game/DestinyShared"); // textures and materials of every map when bUseSharedLibrary is set
+
+	/** Package folder the textures of a CFG folder go to, /Game/<FolderName>/Textures or <SharedLibraryRoot>/Textures */
+	FString GetTexturesPath(const FString& FolderName) const
+	{
+		return (bUseSharedLibrary ? SharedLibraryRoot : TEXT("/Game/") + FolderName) + TEXT("/Textures");
+	}
+
+	/** Package folder the materials of a CFG folder go to, /Game/<FolderName>/Materials or <SharedLibraryRoot>/Materials */
+	FString GetMaterialsPath(const FString& FolderName) const
+	{
+		return (bUseSharedLibrary ? SharedLibraryRoot : TEXT("/Game/") + FolderName) + TEXT("/Materials");
+	}
+};
+
+/** Where one CFG's assets come from and go to */
+struct FCharmCFGContext
+{
+	FString ConfigPath;
+	FString FolderName; // assets go to /Game/<FolderName>
+	FString Type;
+	FString AssetsPath;
+
+	static FString GetFolderName(const FString& ConfigPath)
+	{
+		return FPaths::GetCleanFilename(FPaths::GetPath(ConfigPath)).Replace(TEXT(" "), TEXT("_"));
+	}
+};
+
+/**
+ * One import run. The settings are copied when the session starts, so the plugin window can change
+ * while stages or asynchronous imports are still running, and the caches live and die with the run.
+ * Sessions are passed explicitly to every stage; the caches are only touched on the game thread.
+ */
+struct FCharmImportSession
+{
+	explicit FCharmImportSession(const FCharmImportSettings& InSettings) : Settings(InSettings) {}
+
+	const FCharmImportSettings Settings;
+
+	TMap<FString, TSharedPtr<FJsonObject>> MaterialTexturesCache; // Materials/<hash>.json path -> validated Material.Pixel.Textures
+	TMap<FString, TWeakObjectPtr<UMaterialInterface>> MaterialCache; // material asset path -> material built or loaded this session
+	TSet<FString> ImportedTextureHashes; // <textures path>/<hash> already imported or skipped this session
+	TMap<FString, TSet<FName>> ExistingAssetNames; // package folder -> asset names the asset registry listed there when first asked
+	TMap<FString, TSharedPtr<FCharmAssetsIndex>> AssetsIndices; // AssetsPath -> listing of its Textures, Models and Materials folders
+	TMap<FString, TWeakObjectPtr<UMaterial>> MasterMaterialCache; // master material path -> master shared by every instance with that texture layout
+	TSharedPtr<FCharmInterchangeImporter> InterchangeImporter; // asynchronous model import of this session, if any
+	TStrongObjectPtr<UTextureFactory> InterchangeTextureFactory; // texture fallback of the Interchange callbacks, which outlive FImportModels' own factory
+	bool bDeferMaterialCompiles = false; // set while the materials stage runs, their compile waits for the end of the stage
+	TArray<TWeakObjectPtr<UMaterialInterface>> DeferredMaterialCompiles; // materials and masters built while compiles are deferred, in build order
+	TSet<TWeakObjectPtr<ULevel>> PlacedLevels; // levels a bulk map build labelled actors in without a per-actor Modify, marked dirty once at the end
+	TMap<FString, TArray<TWeakObjectPtr<AActor>>> PendingDataLayerActors; // data layer (CFG Type or Lights) -> actors spawned for it
+	TMap<FString, TSharedPtr<FCharmImportManifest>> Manifests; // FolderName -> sources imported into it, saved when the session ends
+};
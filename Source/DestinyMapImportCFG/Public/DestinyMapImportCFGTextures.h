@@ -0,0 +1,42 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ImageCore.h"
+#include "Engine/TextureDefines.h"
+
+class UTexture2D;
+
+/** One texture of a material JSON Textures entry, resolved to its source file */
+struct FCharmTextureRequest
+{
+	FString Hash;
+	FString SourcePath;
+	FString Format;
+	bool bSRGB = false;
+};
+
+struct FCharmDecodedTexture
+{
+	FCharmTextureRequest Request;
+	FImage Image;
+	bool bDecoded = false;
+};
+
+/**
+ * Decodes texture sources with IImageWrapper on worker threads, keeping at most MaxInFlight decoded
+ * images ahead of the game thread, which only creates the UTexture2D assets from the finished buffers.
+ */
+class FCharmTextureDecoder
+{
+public:
+	/** Maps the Charm DXGI format name to the compression the imported texture should use */
+	static TextureCompressionSettings GetCompressionSettings(const FString& Hash, const FString& Format);
+
+	/** Decodes every request on the thread pool, OnDecoded runs on the calling thread in request order */
+	static void DecodeAll(const TArray<FCharmTextureRequest>& Requests, int32 MaxInFlight, TFunctionRef<void(FCharmDecodedTexture&)> OnDecoded);
+
+	/** Creates <PackagePath>.<Hash> from a decoded image, or refreshes the texture already there, must run on the game thread */
+	static UTexture2D* CreateTexture(const FString& PackagePath, const FCharmDecodedTexture& Decoded);
+};